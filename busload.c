@@ -0,0 +1,141 @@
+/**
+ * @file busload.c
+ * @brief RDRAM loads for contention runs
+ */
+
+#include <libdragon.h>
+
+#include "busload.h"
+
+#ifdef CONTENTION_BENCH
+
+// RDP work kept queued: each batch fills and textures the whole target a few times
+// (a few milliseconds of RDP time), and finished batches are replaced by BusLoadPump
+#define RDP_BATCH_PASSES   4
+#define RDP_BATCHES        4
+#define RDP_TARGET_WIDTH   320
+#define RDP_TARGET_HEIGHT  240
+#define RDP_TEXTURE_SIZE   32
+
+static const char * LoadNames[] = {
+    "off",
+    "16bpp",
+    "32bpp",
+    "rdp"
+};
+
+static bus_load_t ActiveLoad = BUS_LOAD_32BPP;
+static surface_t Target;
+static surface_t Texture;
+static rspq_syncpoint_t Batches[RDP_BATCHES];
+static uint32_t BatchesQueued = 0;
+static uint32_t BatchesDone = 0;
+
+/**
+ * @brief Start the 320x240 double-buffered display the ROM normally uses, at another depth
+ */
+static void StartDisplay(bitdepth_t Depth) {
+    display_init(
+        RESOLUTION_320x240,
+        Depth,
+        2,
+        GAMMA_NONE,
+        ANTIALIAS_RESAMPLE
+    );
+}
+
+/**
+ * @brief Queue one batch of fills and textured rectangles into the offscreen target
+ */
+static void QueueRdpBatch(void) {
+    rdpq_texparms_t Wrap = { .s.repeats = REPEAT_INFINITE, .t.repeats = REPEAT_INFINITE };
+
+    for (int Pass = 0; Pass < RDP_BATCH_PASSES; Pass++) {
+        // A fill only writes RDRAM; the textured copy reads TMEM and writes RDRAM again
+        rdpq_set_mode_fill(RGBA32(Pass * 0x40, 0x80, 0xFF - Pass * 0x40, 0xFF));
+        rdpq_fill_rectangle(0, 0, RDP_TARGET_WIDTH, RDP_TARGET_HEIGHT);
+        rdpq_set_mode_copy(false);
+        rdpq_tex_upload(TILE0, &Texture, &Wrap);
+        rdpq_texture_rectangle(TILE0, 0, 0, RDP_TARGET_WIDTH, RDP_TARGET_HEIGHT, 0, 0);
+    }
+    Batches[BatchesQueued % RDP_BATCHES] = rspq_syncpoint_new();
+    BatchesQueued++;
+    rspq_flush();
+}
+
+/**
+ * @brief Allocate the RDP target and texture and queue the first batches
+ */
+static void StartRdp(void) {
+    Target = surface_alloc(FMT_RGBA16, RDP_TARGET_WIDTH, RDP_TARGET_HEIGHT);
+    Texture = surface_alloc(FMT_RGBA16, RDP_TEXTURE_SIZE, RDP_TEXTURE_SIZE);
+
+    // Checkerboard, so the texture upload and the copies move changing data
+    uint16_t * Texels = (uint16_t *)Texture.buffer;
+    for (int i = 0; i < RDP_TEXTURE_SIZE * RDP_TEXTURE_SIZE; i++) {
+        Texels[i] = ((i ^ (i / RDP_TEXTURE_SIZE)) & 1) ? 0xF801 : 0x07FF;
+    }
+    data_cache_hit_writeback(Texture.buffer, RDP_TEXTURE_SIZE * RDP_TEXTURE_SIZE * 2);
+
+    rdpq_attach(&Target, NULL);
+    BatchesQueued = 0;
+    BatchesDone = 0;
+    for (int i = 0; i < RDP_BATCHES; i++) {
+        QueueRdpBatch();
+    }
+}
+
+/**
+ * @brief Let the queued RDP work finish and free its surfaces
+ */
+static void StopRdp(void) {
+    rspq_wait();
+    rdpq_detach_wait();
+    surface_free(&Target);
+    surface_free(&Texture);
+}
+
+void BusLoadBegin(bus_load_t Load) {
+    assert(Load < NUM_BUS_LOADS);
+
+    // display_close blanks the VI, so the display-off load has no scanout at all
+    display_close();
+    if (Load == BUS_LOAD_16BPP) {
+        StartDisplay(DEPTH_16_BPP);
+    } else if (Load != BUS_LOAD_DISPLAY_OFF) {
+        StartDisplay(DEPTH_32_BPP);
+    }
+
+    if (Load == BUS_LOAD_RDP) {
+        StartRdp();
+    }
+    ActiveLoad = Load;
+}
+
+void BusLoadPump(void) {
+    if (ActiveLoad != BUS_LOAD_RDP) {
+        return;
+    }
+
+    // Replace finished batches, oldest first; the newest are still queued behind them
+    for (int i = 0; i < RDP_BATCHES && rspq_syncpoint_check(Batches[BatchesDone % RDP_BATCHES]); i++) {
+        BatchesDone++;
+        QueueRdpBatch();
+    }
+}
+
+void BusLoadEnd(void) {
+    if (ActiveLoad == BUS_LOAD_RDP) {
+        StopRdp();
+    }
+
+    display_close();
+    StartDisplay(DEPTH_32_BPP);
+    ActiveLoad = BUS_LOAD_32BPP;
+}
+
+const char * BusLoadName(bus_load_t Load) {
+    return (Load < NUM_BUS_LOADS) ? LoadNames[Load] : "unknown";
+}
+
+#endif // CONTENTION_BENCH
@@ -0,0 +1,59 @@
+/**
+ * @file busload.h
+ * @brief RDRAM loads for contention runs
+ *
+ * Enabled with -DCONTENTION_BENCH. The PI writes every DMA into RDRAM, so
+ * its completion time depends on what else uses RDRAM at the same time. A
+ * load sets up one of the conditions a game runs the PI under: no video
+ * scanout, a 16bpp or 32bpp 320x240 double-buffered display, or a 32bpp
+ * display while the RDP keeps filling and texturing an offscreen surface.
+ * Nothing may be drawn to the display while a load is active.
+ */
+
+#ifndef BUSLOAD_H
+#define BUSLOAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Can be defined via Makefile: N64_CFLAGS += -DCONTENTION_BENCH
+//#define CONTENTION_BENCH
+
+// RDRAM loads, from idle to the heaviest
+typedef enum {
+    BUS_LOAD_DISPLAY_OFF = 0,  // VI blanked, no scanout
+    BUS_LOAD_16BPP,            // 320x240 16bpp scanout
+    BUS_LOAD_32BPP,            // 320x240 32bpp scanout (the display the sweep runs with)
+    BUS_LOAD_RDP,              // 32bpp scanout plus rdpq fill and textured rectangles
+    NUM_BUS_LOADS
+} bus_load_t;
+
+#ifdef CONTENTION_BENCH
+
+/**
+ * @brief Switch the display to the load and start any RDP traffic
+ *
+ * The RDP load needs rspq, so the RSP must not run another task.
+ */
+void BusLoadBegin(bus_load_t Load);
+
+/**
+ * @brief Queue more RDP work as queued batches finish (no-op for display-only loads)
+ *
+ * Call between measurements; a batch keeps the RDP busy for a few milliseconds.
+ */
+void BusLoadPump(void);
+
+/**
+ * @brief Stop the load and bring back the 320x240 32bpp double-buffered display
+ */
+void BusLoadEnd(void);
+
+/**
+ * @brief Short name of a load
+ */
+const char * BusLoadName(bus_load_t Load);
+
+#endif // CONTENTION_BENCH
+
+#endif // BUSLOAD_H
@@ -4,8 +4,20 @@
  */
 
 #include <string.h>
+#include <math.h>
 #include <libdragon.h>
 #include "pif.h"
+#include "pidma.h"
+#include "romcheck.h"
+#include "pimodel.h"
+#include "matrixview.h"
+#include "profile.h"
+#include "export.h"
+#include "resultcache.h"
+#include "pisweep.h"
+#include "rspverify.h"
+#include "pilatency.h"
+#include "busload.h"
 
 // Default Domain 1 speed parameters (can be overridden by Makefile defines)
 #ifndef DEFAULT_DOM1_LAT
@@ -24,32 +36,262 @@
 #define RUN_ON_EMULATOR_MODE 0
 #endif
 
-// PI registers structure
-typedef struct PI_regs_s {
-    volatile void * ram_address;
-    uint32_t pi_address;
-    uint32_t read_length;
-    uint32_t write_length;
-} PI_regs_t;
-static volatile PI_regs_t * const PI_regs = (PI_regs_t *)0xA4600000;
+// Sweep strategy: exhaustive tries every PWD for every LAT, frontier walks the
+// staircase of minimum working PWD values (roughly 512 probes instead of 65,536),
+// bisect searches every LAT on its own (tools/pisim compares them on the host)
+// Can be overridden via Makefile: N64_CFLAGS += -DSWEEP_MODE=SWEEP_MODE_EXHAUSTIVE
+// Values match pi_sweep_strategy_t
+#define SWEEP_MODE_EXHAUSTIVE 0
+#define SWEEP_MODE_FRONTIER   1
+#define SWEEP_MODE_BISECT     2
+#ifndef SWEEP_MODE
+#define SWEEP_MODE SWEEP_MODE_FRONTIER
+#endif
+
+// Full-ROM verification: also stream all of Domain 1 into a rolling hash and compare
+// it against a slow-speed pass (the reference pass alone reads 8MB at LAT/PWD=0xFF)
+// Can be defined via Makefile: N64_CFLAGS += -DVERIFY_FULL_ROM
+//#define VERIFY_FULL_ROM
+
+// PGS/RLS search: after the LAT/PWD sweep, also search page size (PGS 0-15) and release
+// time (RLS 0-3) along the frontier and pick the combination with the highest throughput
+// Can be defined via Makefile: N64_CFLAGS += -DSWEEP_PGS_RLS
+//#define SWEEP_PGS_RLS
+
+// Fixed sample locations: probe the first NUM_TEST_LOCATIONS blocks of the ROM instead of
+// the blocks with the most bit transitions found by a scan at safe speed
+// Can be defined via Makefile: N64_CFLAGS += -DFIXED_SAMPLE_LOCATIONS
+//#define FIXED_SAMPLE_LOCATIONS
+
+// Margin testing: repeat probes near the frontier until a sequential probability ratio
+// test decides whether the failure rate is below MARGIN_P0_PPM or at least MARGIN_P1_PPM,
+// and pick the best speed from the resulting per-LAT safe PWD table (plus a guard band)
+// Can be defined via Makefile: N64_CFLAGS += -DMARGIN_TEST
+//#define MARGIN_TEST
+
+// RSP verification: compare probe data and hash verification streams on the RSP while
+// the CPU keeps the PI busy (the CPU takes over if the RSP fails its self-test or stalls)
+// Can be defined via Makefile: N64_CFLAGS += -DRSP_VERIFY
+//#define RSP_VERIFY
+
+// Lane map: after the results, show which AD lines failed first at each LAT
+// Can be defined via Makefile: N64_CFLAGS += -DSHOW_LANE_MAP
+//#define SHOW_LANE_MAP
+
+// Transfer profiles: besides the aligned 128-byte sample probes, sweep a separate frontier for
+// each profile in this mask (bit n = transfer_profile_t n) and only accept timings that every
+// swept profile passes at their LAT
+// Can be defined via Makefile: N64_CFLAGS += -DTRANSFER_PROFILES=0x1E
+//#define TRANSFER_PROFILES 0x1E
+
+// Soak: after the results, keep reading at the chosen timing for this many seconds and
+// compare every chunk with a slow-speed pass; a pass with errors steps back to a slower
+// timing along the frontier and restarts the clock (qualifies a speed, not just finds one)
+// Can be defined via Makefile: N64_CFLAGS += -DSOAK_SECONDS=3600
+//#define SOAK_SECONDS 3600
+
+// Full-ROM soak: soak all of Domain 1 instead of the 1MB checksummed region
+// Can be defined via Makefile: N64_CFLAGS += -DSOAK_FULL_ROM
+//#define SOAK_FULL_ROM
+
+// Write test: after the sweep, sweep a separate frontier for RDRAM->cart DMAs on cart RAM in
+// Domain 1 (flashcart and emulator ISViewer buffers). Reads cannot tell RAM from flash or a
+// 64DD, so the RAM address is given with the flag: only build it for a setup known to have
+// RAM there. Nothing is written unless read-only checks of the region pass first; the memory
+// is read first and restored afterwards
+// Can be defined via Makefile: N64_CFLAGS += -DWRITE_TEST=0x13FF8000
+//#define WRITE_TEST 0x13FF8000
 
 // Domain 1 (cartridge ROM) address space
 #define CART_DOM1_START     0x10000000
 #define CART_DOM1_SIZE       0x00800000  // 8MB
 
+// Domain 2 (SRAM/FlashRAM save memory) address space
+#define CART_DOM2_START     0x08000000
+#define CART_DOM2_SIZE      0x00008000  // 32KB, the largest SRAM
+
+// PI domains SetDomSpeed can program
+#define PI_DOMAIN_1         1
+#define PI_DOMAIN_2         2
+
 // Test configuration
 #define NUM_TEST_LOCATIONS  4
 #define BYTES_PER_LOCATION  128
 #define ADDRESS_SPACING     128  // 128 bytes spacing
+#if NUM_TEST_LOCATIONS > RESULT_CACHE_MAX_SAMPLES
+#error "Result cache entries hold fewer sample blocks than NUM_TEST_LOCATIONS"
+#endif
+
+// Sample selection scan configuration (retail header timing is safe for every licensed cart)
+#define SAMPLE_SCAN_LAT     0x40
+#define SAMPLE_SCAN_PWD     0x12
+#define ROM_MIN_SIZE        0x00100000  // Smallest ROM size checked for a mirror of the header
+
+// Throughput benchmark configuration
+#define BENCH_TRANSFER_SIZE 0x10000  // 64KB per DMA
+#define BENCH_REPEATS       4        // DMAs timed per frontier point
+#define BENCH_TABLE_ENTRIES 6        // Frontier points listed on screen (all are sent over ISViewer)
+#define COMPARE_BENCH_REPEATS 16     // Compares of one probe's sample blocks timed per kernel
+#define PROBE_RATE_PROBES   64       // Probes of the chosen timing timed for the probe rate
+#define MAX_FRONTIER_POINTS 1024     // Frontier points measured, including PGS/RLS search points
+#define CONTENTION_PROBES   64       // Probes of the chosen timing under each RDRAM load
+
+// Cache confirmation: one PWD step faster than the cached frontier is probed CONFIRM_FASTER_PROBES
+// times and only a clear majority of passes (the frontier moved) drops the cached result
+#define CONFIRM_FASTER_PROBES   8
+#define CONFIRM_FASTER_MAJORITY 6
+
+// Margin test configuration (can be overridden by Makefile defines)
+#ifndef MARGIN_P0_PPM
+#define MARGIN_P0_PPM       100    // Probe failure rate still accepted as reliable (per million)
+#endif
+#ifndef MARGIN_P1_PPM
+#define MARGIN_P1_PPM       1000   // Probe failure rate that must be rejected (per million)
+#endif
+#define MARGIN_ALPHA        0.05f  // Chance of rejecting a reliable cell
+#define MARGIN_BETA         0.05f  // Chance of accepting an unreliable cell
+#define MARGIN_MAX_PROBES   20000  // Undecided cells count as unreliable
+#ifndef MARGIN_PROBE_BUDGET
+#define MARGIN_PROBE_BUDGET 100000 // Probes all margin tests of a sweep may take, PGS/RLS search included
+#endif
+#ifndef MARGIN_GUARD_PWD
+#define MARGIN_GUARD_PWD    1      // PWD steps added on top of the reliable PWD
+#endif
+
+// Transfer size the timing model ranks settings for (can be overridden by Makefile defines)
+#ifndef MODEL_WORKLOAD_SIZE
+#define MODEL_WORKLOAD_SIZE BENCH_TRANSFER_SIZE
+#endif
+
+// Streaming reads cycle through STREAM_CHUNKS chunks of BenchBuffer, so a chunk stays
+// untouched until the callback after its own has returned
+#define STREAM_CHUNK_SIZE   (BENCH_TRANSFER_SIZE / 2)
+#define STREAM_CHUNKS       3
+
+// Probe DMAs: a transfer profile issues up to MAX_PROBE_SPANS DMAs, each followed by
+// padding in the arena so a DMA with an odd tail cannot spill into the next one
+#define MAX_PROBE_SPANS     8
+#define PROBE_SPAN_PADDING  16
+#define PAGE_CROSS_ARENA_SIZE (16 + 16 + 128 + 2048 + 4 * PROBE_SPAN_PADDING)  // The four page-crossing DMAs
+#ifdef TRANSFER_PROFILES
+#define PROBE_ARENA_SIZE    (BENCH_TRANSFER_SIZE + PROBE_SPAN_PADDING)  // Room for the burst profile
+#elif defined(SWEEP_PGS_RLS)
+#define PROBE_ARENA_SIZE    (NUM_TEST_LOCATIONS * BYTES_PER_LOCATION + PAGE_CROSS_ARENA_SIZE)  // Room for the search profile
+#else
+#define PROBE_ARENA_SIZE    (NUM_TEST_LOCATIONS * BYTES_PER_LOCATION)
+#endif
+#define TRANSFER_PAGE_ALIGN 0x20000  // Largest PI page (PGS 15), so a page boundary for every PGS
+
+// Domain 2 test configuration (read-only, save memory is never written)
+#define DOM2_SAMPLE_SIZE    0x200   // Bytes of save memory compared per probe (one DMA)
+#define DOM2_BENCH_SIZE     CART_DOM2_SIZE
+#define DOM2_DEFAULT_LAT    0x05    // SRAM timing games commonly use
+#define DOM2_DEFAULT_PWD    0x0C
+#define DOM2_DEFAULT_PGS    0x0D
+#define DOM2_DEFAULT_RLS    0x02
+#define DOM2_FLASH_COMMAND  0x00010000  // FlashRAM command register, offset into Domain 2
+#define DOM2_FLASH_READ_ARRAY 0xF0000000  // FlashRAM command: answer reads from the array
+#define DOM2_FLASH_ID       0x11118001  // First word a FlashRAM in ID mode answers with
+#define DOM2_ID_WORDS       16      // Words read to tell save data from a FlashRAM register
+
+// Write test configuration. The region is the address given with WRITE_TEST, e.g. the upper half
+// of the 64KB ISViewer buffer at 0x13FF0000, away from the registers and the text debugf writes
+// from 0x13FF0020
+#define WRITE_TEST_SIZE     0x400   // Bytes written and read back per probe (one DMA each way)
+#define WRITE_BENCH_REPEATS 64      // WRITE_TEST_SIZE DMAs timed per write throughput measurement
+#ifdef WRITE_TEST
+#define WRITE_REGION_START  WRITE_TEST
+#if (WRITE_REGION_START & 7) != 0 || WRITE_REGION_START < CART_DOM1_START + CART_DOM1_SIZE || \
+    WRITE_REGION_START + WRITE_TEST_SIZE > 0x1FC00000
+#error "WRITE_TEST must be the 8-byte aligned address of cart RAM past the ROM window, e.g. -DWRITE_TEST=0x13FF8000"
+#endif
+#endif
+
+// io_read calls timed for the PIO per-access latency
+#define PIO_LATENCY_WORDS   1024
+
+// DMAs timed at slowest speed to separate the fixed per-DMA cost from bus time
+#define LATENCY_CAL_SHORT   128
+#define LATENCY_CAL_LONG    2048
+#define LATENCY_CAL_REPEATS 4
+
+// Region read over and over by the soak, compared per stream chunk
+#ifdef SOAK_FULL_ROM
+#define SOAK_REGION_START   0
+#define SOAK_REGION_SIZE    CART_DOM1_SIZE
+#else
+#define SOAK_REGION_START   ROM_CHECKSUM_START
+#define SOAK_REGION_SIZE    ROM_CHECKSUM_LENGTH
+#endif
+#define SOAK_CHUNKS         (SOAK_REGION_SIZE / STREAM_CHUNK_SIZE)
+#define SOAK_MAX_STEPBACKS  8     // Slower timings tried before the soak gives up
+
+// State machine timing: presence polls start fast after a change and slow down while
+// nothing happens, a new cart gets a moment for its contacts to settle
+#define POLL_MIN_MS         16    // One frame
+#define POLL_MAX_MS         256
+#define INSERT_SETTLE_MS    50
+#define RESULT_PAGE_MS      3000  // Each result page stays up this long (pulling the cart skips them)
 
 // State machine
 typedef enum {
     STATE_INIT = 0,
     STATE_SAFE_REMOVE,
     STATE_DETECT,
-    STATE_TEST
+    STATE_TEST,
+    STATE_RESULTS,
+#ifdef CONTENTION_BENCH
+    STATE_CONTENTION,
+#endif
+#ifdef SOAK_SECONDS
+    STATE_SOAK
+#endif
 } test_state_t;
 
+// Shapes of the DMAs TestSpeed issues
+typedef enum {
+    TRANSFER_SAMPLES = 0,     // Aligned 128-byte sample blocks, merged where adjacent (the default)
+    TRANSFER_SIZES,           // 2 bytes to 32 KiB in steps of 4x
+    TRANSFER_BURST,           // One 64 KiB DMA over many pages
+    TRANSFER_PAGE_CROSS,      // Short DMAs starting just before a page boundary
+    TRANSFER_ODD,             // Odd lengths and starts that are not 8-byte aligned
+    TRANSFER_TIMING_SEARCH,   // Sample blocks plus the page-crossing DMAs (PGS/RLS search)
+    NUM_TRANSFER_PROFILES
+} transfer_profile_t;
+
+// Pages shown one after the other once the results are up (pages not built in are skipped)
+typedef enum {
+    PAGE_HEADER_PATCH = 0,
+    PAGE_MARGIN,
+    PAGE_PIO_FRONTIER,
+    PAGE_DOM2_FRONTIER,
+    PAGE_WRITE_FRONTIER,
+    PAGE_TRANSFER_PROFILES,
+    PAGE_CONTENTION,
+    PAGE_LANE_MAP,
+    PAGE_LATENCY_MAP,
+    PAGE_SOAK,
+    PAGE_PROBE_STATS,
+    PAGE_PROFILE,
+    NUM_RESULT_PAGES
+} result_page_t;
+
+// CPU cycles to compare one probe's sample blocks, read through KSEG1 as TestSpeed does
+typedef struct {
+    uint32_t LanesMatch;      // RomCompareLanes, blocks match
+    uint32_t MemcmpMatch;     // memcmp, blocks match
+    uint32_t LanesMismatch;   // RomCompareLanes, first byte differs
+    uint32_t MemcmpMismatch;  // memcmp, first byte differs
+} compare_bench_t;
+
+// A region the throughput benchmark moves with back-to-back DMAs
+typedef struct {
+    int Domain;  // PI_DOMAIN_1 or PI_DOMAIN_2, whose timing is set
+    uint32_t (*StartDma)(void * Buffer, uint32_t Offset, uint32_t Len);  // Starts one DMA at Offset 0
+    uint32_t Len;  // Bytes per DMA, at most BENCH_TRANSFER_SIZE
+    void (*BeforeDma)(void);  // Called untimed before every DMA, NULL for none
+} bench_target_t;
+
 // Speed level definitions
 typedef enum {
     SPEED_LEVEL_TOTAL_POS = 0,
@@ -76,79 +318,331 @@ static const char * SpeedLevelNames[] = {
     "is a perfectionist"
 };
 
-// Speed level to LAT/PWD mapping
-static const uint8_t SpeedLevelLAT[] = {
-    0xFF,  // Level 0: Total POS
-    0xE0,  // Level 1: Absolute POS
-    0xC0,  // Level 2: Basically POS
-    0xA0,  // Level 3: Mini POS
-    0x80,  // Level 4: Slightly POS
-    0x60,  // Level 5: Could work
-    0x40,  // Level 6: Does work (anchored)
-    0x20,  // Level 7: Overachiever
-    0x00   // Level 8: Perfectionist
+// Minimum predicted throughput for each speed level, in percent of the retail timing
+// (0x40/0x12/7/3), for a MODEL_WORKLOAD_SIZE transfer
+static const uint16_t SpeedLevelMinPercent[] = {
+    0,    // Level 0: Total POS
+    10,   // Level 1: Absolute POS
+    12,   // Level 2: Basically POS
+    15,   // Level 3: Mini POS
+    22,   // Level 4: Slightly POS
+    37,   // Level 5: Could work
+    100,  // Level 6: Does work (anchored: at least as fast as retail)
+    128,  // Level 7: Overachiever
+    277   // Level 8: Perfectionist
 };
 
-static const uint8_t SpeedLevelPWD[] = {
-    0xFF,  // Level 0: Total POS
-    0xD4,  // Level 1: Absolute POS
-    0xA9,  // Level 2: Basically POS
-    0x7E,  // Level 3: Mini POS
-    0x53,  // Level 4: Slightly POS
-    0x28,  // Level 5: Could work
-    0x12,  // Level 6: Does work (anchored)
-    0x09,  // Level 7: Overachiever
-    0x00   // Level 8: Perfectionist
-};
+// Measured throughput of one point on the LAT/PWD frontier
+typedef struct {
+    uint8_t LAT;
+    uint8_t PWD;
+    uint8_t PGS;
+    uint8_t RLS;
+    uint32_t KBPerSec;           // Measured, 1 KB = 1000 bytes
+    uint32_t PredictedKBPerSec;  // Timing model prediction for the same transfers
+    bool VerifyFailed;  // Failed whole-region verification
+} frontier_point_t;
+
+// Candidate sample block found by the selection scan
+typedef struct {
+    uint32_t Offset;
+    uint32_t Toggles;
+} sample_block_t;
+
+// Called for each chunk of a streamed Domain 1 region
+typedef void (*stream_callback_t)(const uint8_t * Data, uint32_t Offset, uint32_t Len, void * Context);
+
+// Adjacent sample blocks, fetched by TestSpeed with a single DMA
+typedef struct {
+    uint32_t Offset;       // ROM offset of the first block
+    uint32_t Len;          // Bytes covered (a multiple of BYTES_PER_LOCATION)
+    uint32_t ArenaOffset;  // Position in ProbeArena and ReferenceData
+} probe_span_t;
+
+// Header timing word rewritten to the chosen timing
+typedef struct {
+    uint32_t StockWord;
+    uint32_t PatchedWord;
+    uint32_t StockBootUs;     // Predicted IPL3 load of the checksummed 1MB at the stock timing
+    uint32_t PatchedBootUs;   // The same at the patched timing
+    char IpsHex[ROM_IPS_WORD_PATCH_SIZE * 2 + 1];  // IPS patch for a .z64 image as hex digits
+} header_patch_t;
+
+// Running state of a verification pass
+typedef struct {
+    bool WithChecksum;
+    rom_checksum_t Checksum;
+    uint32_t Hash;
+#ifdef RSP_VERIFY
+    bool Pending;                // A hash job of the previous chunk is still to be folded in
+    int32_t PendingJob;          // Its job number, -1 if the RSP did not take it
+    const uint8_t * PendingData; // Its chunk, for the CPU fallback
+    uint32_t PendingLen;
+#endif
+} verify_stream_t;
+
+// Sweep and benchmark of the chosen timing under one RDRAM load
+typedef struct {
+    bool Measured;            // Run for this cart 
+    bool Passes;              // Chosen timing passed all CONTENTION_PROBES probes
+    uint8_t MinPWDForLAT[256];
+    uint32_t KBPerSec;        // Chosen timing
+    int Stricter;             // LATs needing a higher PWD than with the display off
+} load_result_t;
+
+// Running state of the soak
+typedef struct {
+    uint8_t LAT;              // Timing being soaked
+    uint8_t PWD;
+    uint8_t PGS;
+    uint8_t RLS;
+    uint8_t StartLAT;         // Timing the soak started at
+    uint8_t StartPWD;
+    int StepBacks;            // Slower timings moved to after errors
+    bool Failed;              // No timing survived SOAK_MAX_STEPBACKS step backs
+    uint64_t StartTicks;      // Start of the whole soak
+    uint64_t TimingTicks;     // Start of the soak at the current timing
+    uint64_t FirstErrorTicks; // Time to the first error, 0 if none yet
+    uint64_t DisplayTicks;    // Last live update
+    uint64_t BytesRead;
+    uint32_t Errors;          // Chunks that did not match the slow-speed pass
+    uint32_t PassErrors;      // The same during the current pass, not yet counted in Errors
+    uint64_t PassErrorTicks;  // When the current pass saw its first error
+    uint32_t PassErrorOffset; // ROM offset of that chunk
+    uint32_t Passes;
+} soak_state_t;
 
 // Global state
 static test_state_t CurrentState = STATE_INIT;
-static uint8_t ReferenceData[NUM_TEST_LOCATIONS][BYTES_PER_LOCATION] __attribute__ ((aligned(16)));
+static test_state_t PreviousState = STATE_INIT;  // State of the last HandleStateMachine call
+static uint32_t PollMs = POLL_MIN_MS;            // Current presence poll interval
+static timer_link_t * WakeTimer = NULL;          // Fires when the state machine's next deadline has passed
+static volatile bool WakePending = false;        // Set by WakeTimer, main sleeps until it is
+static uint64_t InsertTicks = 0;                 // When the presence poll first saw the cart, 0 if none
+static uint64_t InsertToResultTicks = 0;         // From InsertTicks to the first result on screen
+static uint64_t PageDeadline = 0;                // When the current result page is replaced
+static int ResultPage = 0;                       // Next result_page_t to show
+static uint8_t ResultLAT = 0xFF;                 // Timing chosen for the cart under test
+static uint8_t ResultPWD = 0xFF;
+static uint8_t ResultPGS = 0x07;
+static uint8_t ResultRLS = 0x03;
+static speed_level_t ResultLevel;
+static uint8_t ReferenceData[PROBE_ARENA_SIZE] __attribute__ ((aligned(16)));  // Probe spans at slowest speed, in span order
+static uint8_t ProbeArena[PROBE_ARENA_SIZE] __attribute__ ((aligned(16)));     // Probe DMA target, only read through KSEG1
+static uint32_t DetectWords[4] __attribute__ ((aligned(16)));  // Presence DMA target, only read through KSEG1
+static uint8_t Dom2Reference[DOM2_SAMPLE_SIZE] __attribute__ ((aligned(16)));  // Save memory at slowest speed
+static uint8_t Dom2Arena[DOM2_SAMPLE_SIZE] __attribute__ ((aligned(16)));      // Domain 2 probe DMA target, only read through KSEG1
+static uint8_t Dom2MinPWDForLAT[256];  // Minimum working Domain 2 PWD for each LAT, 0xFF if none found
+static bool Dom2Present = false;       // Save memory answered with stable data at slowest speed
+static bool Dom2Pattern = false;       // The reference changes every AD line, so probes can see errors
+static bool Dom2Identified = false;    // The save read as data, or as a FlashRAM by its ID
+static uint32_t Dom2SampleOffset = 0;  // Save offset of the window TestSpeedDom2 compares
+static uint8_t Dom2BestLAT = 0xFF;     // Domain 2 frontier corner predicted fastest for a whole-save read
+static uint8_t Dom2BestPWD = 0xFF;
+static uint32_t Dom2KBPerSec = 0;      // Save-read throughput at Dom2BestLAT/PWD
+static uint32_t Dom2DefaultKBPerSec = 0;  // Save-read throughput at the common SRAM timing
+#ifdef WRITE_TEST
+static uint8_t WriteOriginal[WRITE_TEST_SIZE] __attribute__ ((aligned(16)));     // Write region before the test, only read through KSEG1
+static uint8_t WritePatterns[2][WRITE_TEST_SIZE] __attribute__ ((aligned(16)));  // Complementary patterns, written back from the cache once
+static uint8_t WriteArena[WRITE_TEST_SIZE] __attribute__ ((aligned(16)));        // Read-back DMA target, only read through KSEG1
+static uint8_t WriteMinPWDForLAT[256];  // Minimum working write PWD for each LAT, 0xFF if none found
+static bool WritePresent = false;       // The write region held what was written at slowest speed
+static bool WriteTested = false;        // The write test ran for the cart on screen
+static uint32_t WriteProbeCount = 0;    // Picks the pattern of the next write probe
+static uint8_t WriteBestLAT = 0xFF;     // Write frontier corner predicted fastest for a WRITE_TEST_SIZE write
+static uint8_t WriteBestPWD = 0xFF;
+static uint32_t WriteKBPerSec = 0;      // Write throughput at WriteBestLAT/PWD
+static uint32_t WriteDefaultKBPerSec = 0;  // Write throughput at the retail timing
+#endif
+static probe_span_t ProbeSpans[MAX_PROBE_SPANS];
+static transfer_profile_t ActiveTransferProfile = TRANSFER_SAMPLES;  // Shape of the probe spans
+static int NumProbeSpans = 0;
+static uint64_t ProbeTicks = 0;  // Time spent in TestSpeed during the current sweep
+static compare_bench_t CompareBench;  // Compare kernel timing, measured at startup
+static bool ProbesUncounted = false;  // TestSpeed/TestSpeedPio calls outside the sweep leave its counters and latency cells alone
+static pidma_stats_t SweepDmaStats;   // PI DMA statistics of the sweep (or cache confirmation)
+static uint32_t CpuProbesPerSec = 0;  // Probe rate at the chosen timing with CPU compares, 0 if not measured
+static uint32_t RspProbesPerSec = 0;  // The same with RSP compares, 0 if not measured
+static sample_block_t SampleBlocks[NUM_TEST_LOCATIONS];  // ROM blocks probed by TestSpeed
+static uint8_t SampleData[NUM_TEST_LOCATIONS][BYTES_PER_LOCATION];  // Contents of SampleBlocks during the scan
+static bool SampleBlocksCached = false;  // SampleBlocks were restored from the result cache
+static uint32_t CartRomSize = CART_DOM1_SIZE;  // Bytes of Domain 1 the ROM fills
 static char CartridgeName[21];  // 20 bytes + null terminator
 static bool FirstInit = true;  // Track if this is the first initialization
+static uint32_t StockHeaderWord = 0;  // Header timing word of the cart under test, read at slowest speed
 static uint8_t MinPWDForLAT[256];  // Minimum working PWD for each LAT (0-255), 0xFF if none found
+static bool FrontierViolation[256];  // LATs whose minimum PWD went up compared to the previous LAT
+static int FrontierViolationCount = 0;
+static uint8_t PioMinPWDForLAT[256];  // Minimum working PWD for CPU (io_read) loads, 0xFF if none found
+static bool PioStricter[256];         // LATs where PIO needs a higher PWD than DMA
+static int PioStricterCount = 0;
+static uint8_t CandidatePWDForLAT[256];  // PWD that works for both read paths at each LAT
+static uint32_t PioProbeCount = 0;    // Number of TestSpeedPio calls in the current sweep
+static uint32_t DmaWordNs = 0;        // Time per 32-bit word of a large DMA at the chosen timing
+static uint32_t PioWordNs = 0;        // Time per io_read at the chosen timing
+static uint16_t FirstFailLanes[256];  // AD lines wrong at the fastest failing PWD below each LAT's minimum
+static uint16_t LastProbeLanes = 0;   // AD lines wrong in the last failed TestSpeed call
+#ifdef MARGIN_TEST
+static uint8_t SafePWDForLAT[256];  // Reliable PWD plus guard band for each LAT, 0xFF if none found
+static int MarginalLATCount = -1;   // LATs whose reliable PWD is above the single-pass minimum, -1 if not run
+static bool MarginalLAT[256];       // The same per LAT, highlighted on the margin page
+static uint32_t MarginProbes = 0;   // Probes the margin tests took, at most MARGIN_PROBE_BUDGET
+static bool MarginBudgetHit = false;  // Cells after the budget ran out count as unreliable
+#endif
+static uint32_t ProbeCount = 0;  // Number of TestSpeed calls in the current sweep
+static frontier_point_t FrontierPoints[MAX_FRONTIER_POINTS];  // Frontier corners with measured throughput
+static int NumFrontierPoints = 0;
+static uint32_t BestKBPerSecMeasured = 0;  // Throughput of the chosen best combination
+static uint8_t BenchBuffer[STREAM_CHUNKS * STREAM_CHUNK_SIZE] __attribute__ ((aligned(16)));  // At least BENCH_TRANSFER_SIZE
+static uint8_t BootRegion[ROM_BOOT_REGION_SIZE] __attribute__ ((aligned(16)));  // Header + boot code at slowest speed
+static cic_type_t CartCic = CIC_UNKNOWN;
+static bool HeaderCrcValid = false;   // Header CRC1/CRC2 usable (cleared if they fail at slowest speed too)
+static bool RegionHashValid = false;  // RegionHashRef holds the slow-speed hash of the checksummed region
+static uint32_t RegionHashRef = 0;
+static bool FullRomHashValid = false; // FullRomHashRef holds the slow-speed hash of all of Domain 1
+static uint32_t FullRomHashRef = 0;
+#ifdef RSP_VERIFY
+static bool HashOnRsp = false;        // Verification hashes are built from RSP signatures
+#endif
+#ifdef DMA_LATENCY
+static uint16_t LatencyNs[256];        // Measured bus time per halfword at each LAT's minimum PWD, 0xFFFF if not timed
+static uint8_t LatencyTensOfNs[256];   // The same in tens of ns for the matrix, 0xFF if not timed
+static bool LatencyMismatch[256];      // LATs whose minimum-PWD cell is off the timing model
+static pi_latency_summary_t LatencySummary;
+#endif
+static int VerifyStepBacks = 0;       // Frontier points rejected by verification
+static uint64_t SweepTicks = 0;       // Duration of the last RunSpeedTest
+#ifdef TRANSFER_PROFILES
+static const char * TransferProfileNames[NUM_TRANSFER_PROFILES] = {
+    "samples", "sizes", "burst", "pagecross", "odd", "search"
+};
+static uint8_t ProfileMinPWDForLAT[NUM_TRANSFER_PROFILES][256];  // Frontier of each swept profile, 0xFF if none found
+static uint8_t TransferPWDForLAT[256];  // Highest PWD any swept profile needs at each LAT
+static bool ProfileStricter[256];       // LATs where the strictest profile needs a higher PWD than the samples
+static int ProfileStricterCount = 0;
+static int StrictestProfile = -1;       // Profile whose fastest frontier cell is slowest, -1 if not swept
+#endif
+#ifdef CONTENTION_BENCH
+static load_result_t LoadResults[NUM_BUS_LOADS];
+static bool LoadStricter[256];        // LATs where the worst load needs a higher PWD than display off
+static int WorstLoad = -1;            // Load with the most stricter LATs, -1 if not run
+#endif
+#ifdef SOAK_SECONDS
+static uint32_t SoakChunkHash[SOAK_CHUNKS];  // Slow-speed hash of every chunk of the soak region
+static bool SoakMarks[256];           // LAT being soaked, highlighted in the matrix
+static soak_state_t Soak;
+#endif
 
 /**
- * @brief Read from Domain 1 (cartridge ROM)
+ * @brief Queue a read from Domain 1 (cartridge ROM) without waiting for it
+ * @return Ticket to pass to PiDmaWait
  */
-void CartDom1Read(void * Dest, uint32_t Offset, uint32_t Len) {
+uint32_t CartDom1ReadAsync(void * Dest, uint32_t Offset, uint32_t Len) {
     assert(Dest != NULL);
     assert(Offset < CART_DOM1_SIZE);
     assert(Len > 0);
     assert(Offset + Len <= CART_DOM1_SIZE);
 
-    disable_interrupts();
-    dma_wait();
+    return PiDmaRead(Dest, Offset | CART_DOM1_START, Len);
+}
 
-    MEMORY_BARRIER();
-    PI_regs->ram_address = UncachedAddr(Dest);
-    MEMORY_BARRIER();
-    PI_regs->pi_address = Offset | CART_DOM1_START;
-    MEMORY_BARRIER();
-    PI_regs->write_length = Len - 1;
-    MEMORY_BARRIER();
+/**
+ * @brief Read from Domain 1 (cartridge ROM)
+ */
+void CartDom1Read(void * Dest, uint32_t Offset, uint32_t Len) {
+    PROFILE_BEGIN(Start);
+    PiDmaWait(CartDom1ReadAsync(Dest, Offset, Len));
+    PROFILE_END(PROFILE_CART_READ, Start);
+}
 
-    enable_interrupts();
-    dma_wait();
+/**
+ * @brief Stream a Domain 1 region through a callback
+ *
+ * Reads cycle through STREAM_CHUNKS chunks of BenchBuffer, so the callback works
+ * on one chunk while the next one is on the bus. A chunk is only refilled after
+ * the following callback has returned, so work a callback leaves running on its
+ * chunk (an RSP job) can be collected in the next callback.
+ */
+void CartDom1Stream(uint32_t Offset, uint32_t Len, stream_callback_t Callback, void * Context) {
+    uint32_t Tickets[STREAM_CHUNKS];
+    int Current = 0;
+    
+    data_cache_hit_writeback_invalidate(BenchBuffer, sizeof(BenchBuffer));
+    Tickets[0] = CartDom1ReadAsync(BenchBuffer, Offset, (Len < STREAM_CHUNK_SIZE) ? Len : STREAM_CHUNK_SIZE);
+    
+    for (uint32_t Position = 0; Position < Len; ) {
+        uint32_t ChunkLen = (Len - Position < STREAM_CHUNK_SIZE) ? (Len - Position) : STREAM_CHUNK_SIZE;
+        uint32_t Next = Position + ChunkLen;
+        uint8_t * Chunk = BenchBuffer + Current * STREAM_CHUNK_SIZE;
+        int Following = (Current + 1) % STREAM_CHUNKS;
+        
+        // Queue the next chunk before processing this one
+        if (Next < Len) {
+            uint32_t NextLen = (Len - Next < STREAM_CHUNK_SIZE) ? (Len - Next) : STREAM_CHUNK_SIZE;
+            Tickets[Following] = CartDom1ReadAsync(BenchBuffer + Following * STREAM_CHUNK_SIZE, Offset + Next, NextLen);
+        }
+        
+        PiDmaWait(Tickets[Current]);
+        data_cache_hit_invalidate(Chunk, ChunkLen);
+        Callback(Chunk, Offset + Position, ChunkLen, Context);
+        
+        Position = Next;
+        Current = Following;
+    }
 }
 
 /**
- * @brief Set Domain 1 speed parameters
+ * @brief Set the PI bus timing of a domain
+ * @param Domain PI_DOMAIN_1 (cartridge ROM) or PI_DOMAIN_2 (SRAM/FlashRAM)
  */
-void SetDom1Speed(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+void SetDomSpeed(int Domain, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
     #define PI_BASE_REG          0x04600000
     #define PI_BSD_DOM1_LAT_REG  (PI_BASE_REG+0x14)
     #define PI_BSD_DOM1_PWD_REG  (PI_BASE_REG+0x18)
     #define PI_BSD_DOM1_PGS_REG  (PI_BASE_REG+0x1C)
     #define PI_BSD_DOM1_RLS_REG  (PI_BASE_REG+0x20)
+    #define PI_BSD_DOM2_LAT_REG  (PI_BASE_REG+0x24)
+    #define PI_BSD_DOM2_PWD_REG  (PI_BASE_REG+0x28)
+    #define PI_BSD_DOM2_PGS_REG  (PI_BASE_REG+0x2C)
+    #define PI_BSD_DOM2_RLS_REG  (PI_BASE_REG+0x30)
     #define KSEG1 0xA0000000
     #define PHYS_TO_K1(x)       ((uint32_t)(x)|KSEG1)
     #define IO_WRITE(addr,data) (*(volatile uint32_t *)PHYS_TO_K1(addr)=(uint32_t)(data))
     
-    IO_WRITE(PI_BSD_DOM1_LAT_REG, LAT);
-    IO_WRITE(PI_BSD_DOM1_PWD_REG, PWD);
-    IO_WRITE(PI_BSD_DOM1_PGS_REG, PGS);
-    IO_WRITE(PI_BSD_DOM1_RLS_REG, RLS);
+    // Never change timings under a transfer that is still on the bus
+    PiDmaWaitIdle();
+    
+    if (Domain == PI_DOMAIN_2) {
+        IO_WRITE(PI_BSD_DOM2_LAT_REG, LAT);
+        IO_WRITE(PI_BSD_DOM2_PWD_REG, PWD);
+        IO_WRITE(PI_BSD_DOM2_PGS_REG, PGS);
+        IO_WRITE(PI_BSD_DOM2_RLS_REG, RLS);
+    } else {
+        IO_WRITE(PI_BSD_DOM1_LAT_REG, LAT);
+        IO_WRITE(PI_BSD_DOM1_PWD_REG, PWD);
+        IO_WRITE(PI_BSD_DOM1_PGS_REG, PGS);
+        IO_WRITE(PI_BSD_DOM1_RLS_REG, RLS);
+    }
+}
+
+/**
+ * @brief Set Domain 1 (cartridge ROM) speed parameters
+ */
+void SetDom1Speed(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    SetDomSpeed(PI_DOMAIN_1, LAT, PWD, PGS, RLS);
+}
+
+/**
+ * @brief Read a few words of Domain 1 as one DMA burst (pi_bus_t ReadWords)
+ */
+static void BusReadDom1Words(void * Context, uint32_t Offset, uint32_t * Out, int Count) {
+    assert(Count > 0 && Count <= (int)(sizeof(DetectWords) / sizeof(DetectWords[0])));
+    
+    CartDom1Read(DetectWords, Offset, Count * sizeof(uint32_t));
+    const volatile uint32_t * Words = UncachedAddr(DetectWords);
+    for (int i = 0; i < Count; i++) {
+        Out[i] = Words[i];
+    }
 }
 
 /**
@@ -157,293 +651,3041 @@ void SetDom1Speed(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
  * Open bus: when no cartridge, reading returns lower 16 bits of address
  */
 bool CartDetectPresence(void) {
-    uint32_t TestAddresses[] = {0x10000000, 0x10000004, 0x10000008, 0x1000000C};
-    uint32_t ReadValues[4] __attribute__ ((aligned(16)));
-    
-    // Read from test addresses
-    data_cache_hit_invalidate(ReadValues, sizeof(ReadValues));
-    for (int i = 0; i < 4; i++) {
-        CartDom1Read(&ReadValues[i], TestAddresses[i] - CART_DOM1_START, sizeof(uint32_t));
-    }
-    data_cache_hit_invalidate(ReadValues, sizeof(ReadValues));
-    
-    // Display read values
-#if 0
-    printf("Cart detection reads:\n");
-    for (int i = 0; i < 4; i++) {
-        printf("  0x%08lX -> 0x%08lX\n", (unsigned long)TestAddresses[i], (unsigned long)ReadValues[i]);
-    }
-    console_render();
-#endif
-
-    // Check if values match open bus pattern (lower 16 bits of address)
-    // On N64 (big-endian), the 16-bit value may appear in different positions
-    // Only check array indices 0 and 2
-    int CheckIndices[] = {0, 2};
-    for (int j = 0; j < 2; j++) {
-        int i = CheckIndices[j];
-        uint32_t Address = TestAddresses[i];
-        uint32_t Lower16Bits = Address & 0xFFFF;
-        uint32_t ReadValue = ReadValues[i];
-        
-        // Check if read value matches lower 16 bits
-        // On big-endian, check both lower and upper 16 bits
-        uint16_t ReadLower16 = (uint16_t)(ReadValue & 0xFFFF);
-        uint16_t ReadUpper16 = (uint16_t)((ReadValue >> 16) & 0xFFFF);
-        
-        if (ReadLower16 == (uint16_t)Lower16Bits || ReadUpper16 == (uint16_t)Lower16Bits) {
-            // Matches open bus pattern - continue checking
+    // Only word reads are needed, so the probe is left out
+    const pi_bus_t Bus = { NULL, BusReadDom1Words, NULL };
+    return PiSweepDetectPresence(&Bus, CART_DOM1_START);
+}
+
+/**
+ * @brief Check for a cartridge with a single PIO read, for frequent polls
+ *
+ * Must not be called while a DMA is in flight. CartDetectPresence confirms
+ * with more words before a cart is tested.
+ */
+bool CartProbePresence(void) {
+    return !PiSweepWordIsOpenBus(CART_DOM1_START, io_read(CART_DOM1_START));
+}
+
+/**
+ * @brief Read cartridge name from ROM header
+ */
+bool CartReadName(char * NameBuffer, size_t BufferSize) {
+    if (NameBuffer == NULL || BufferSize < 21) {
+        return false;
+    }
+    
+    uint8_t NameData[32] __attribute__ ((aligned(16)));
+    data_cache_hit_invalidate(NameData, sizeof(NameData));
+    CartDom1Read(NameData, 0x20, sizeof(NameData));
+    data_cache_hit_invalidate(NameData, sizeof(NameData));
+    
+    // Copy and validate name
+    bool HasValidChars = false;
+    for (int i = 0; i < 20; i++) {
+        if (NameData[i] >= 0x20 && NameData[i] <= 0x7E) {
+            HasValidChars = true;
+        }
+        NameBuffer[i] = NameData[i];
+    }
+    NameBuffer[20] = '\0';  // Ensure null termination
+    
+    return HasValidChars;
+}
+
+/**
+ * @brief Find how much of the Domain 1 window the ROM fills
+ *
+ * The header has no size field. A ROM smaller than the window shows up again
+ * (mirrored) or leaves open bus after its end, so the first power of two from
+ * ROM_MIN_SIZE up where the header repeats or nothing answers is the size.
+ * Open bus is checked with single-word PIO reads of words 0 and 2, since a
+ * DMA burst repeats the address it started at in every word.
+ * @return ROM size in bytes, CART_DOM1_SIZE if the ROM fills the whole window
+ */
+uint32_t CartDetectRomSize(void) {
+    uint8_t Header[ROM_HEADER_SIZE] __attribute__ ((aligned(16)));
+    uint8_t Probe[ROM_HEADER_SIZE] __attribute__ ((aligned(16)));
+    
+    data_cache_hit_invalidate(Header, sizeof(Header));
+    CartDom1Read(Header, 0, sizeof(Header));
+    data_cache_hit_invalidate(Header, sizeof(Header));
+    
+    for (uint32_t Size = ROM_MIN_SIZE; Size < CART_DOM1_SIZE; Size *= 2) {
+        data_cache_hit_invalidate(Probe, sizeof(Probe));
+        CartDom1Read(Probe, Size, sizeof(Probe));
+        data_cache_hit_invalidate(Probe, sizeof(Probe));
+        
+        bool OpenBus = true;
+        for (uint32_t i = 0; i < 16 && OpenBus; i += 8) {
+            OpenBus = PiSweepWordIsOpenBus(CART_DOM1_START + Size + i, io_read(CART_DOM1_START + Size + i));
+        }
+        if (OpenBus || memcmp(Probe, Header, sizeof(Header)) == 0) {
+            return Size;
+        }
+    }
+    return CART_DOM1_SIZE;
+}
+
+/**
+ * @brief Check whether every word of a streamed block is open bus
+ *
+ * An empty slot latches the address once per DMA burst, so every word repeats
+ * the pattern of the address the chunk's DMA started at, not its own.
+ * @param BurstAddress PI address the DMA that read the block started at
+ */
+static bool SampleBlockIsOpenBus(const uint8_t * Block, uint32_t BurstAddress) {
+    for (uint32_t i = 0; i < BYTES_PER_LOCATION; i += 4) {
+        if (!PiSweepWordIsOpenBus(BurstAddress, RomReadWord(Block + i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Stream callback: keep the NUM_TEST_LOCATIONS blocks with the most bit transitions
+ *
+ * Open bus and blocks identical to one already kept (mirrors, repeated filler)
+ * are skipped, since they would only probe the same data again.
+ */
+static void SampleScanCallback(const uint8_t * Data, uint32_t Offset, uint32_t Len, void * Context) {
+    for (uint32_t Position = 0; Position < Len; Position += BYTES_PER_LOCATION) {
+        const uint8_t * Block = Data + Position;
+        uint32_t Toggles = RomToggleDensity(Block, BYTES_PER_LOCATION);
+        
+        // SampleBlocks is sorted by descending toggle count
+        int Slot = NUM_TEST_LOCATIONS;
+        while (Slot > 0 && Toggles > SampleBlocks[Slot - 1].Toggles) {
+            Slot--;
+        }
+        if (Slot == NUM_TEST_LOCATIONS) {
+            continue;
+        }
+        
+        // Rare once the list has filled up, so the extra checks cost little
+        if (SampleBlockIsOpenBus(Block, CART_DOM1_START + Offset)) {
+            continue;
+        }
+        bool Duplicate = false;
+        for (int i = 0; i < NUM_TEST_LOCATIONS && !Duplicate; i++) {
+            Duplicate = (SampleBlocks[i].Toggles == Toggles &&
+                         memcmp(SampleData[i], Block, BYTES_PER_LOCATION) == 0);
+        }
+        if (Duplicate) {
+            continue;
+        }
+        
+        for (int i = NUM_TEST_LOCATIONS - 1; i > Slot; i--) {
+            SampleBlocks[i] = SampleBlocks[i - 1];
+            memcpy(SampleData[i], SampleData[i - 1], BYTES_PER_LOCATION);
+        }
+        SampleBlocks[Slot].Offset = Offset + Position;
+        SampleBlocks[Slot].Toggles = Toggles;
+        memcpy(SampleData[Slot], Block, BYTES_PER_LOCATION);
+    }
+}
+
+/**
+ * @brief Choose the blocks TestSpeed probes
+ *
+ * Scans the ROM at a safe speed and picks the blocks with the most data-line
+ * toggles between consecutive halfwords, since those fail first at tight
+ * timings. The number of DMAs per probe stays the same. Only the part of the
+ * window the ROM fills is scanned, and a cart whose cached result did not
+ * confirm keeps the blocks from the cache instead of scanning again.
+ */
+void SelectSampleBlocks(void) {
+    if (SampleBlocksCached) {
+        debugf("Sample blocks from the result cache\n");
+        return;
+    }
+    
+    // Default to the first blocks of the ROM
+    for (int i = 0; i < NUM_TEST_LOCATIONS; i++) {
+        SampleBlocks[i].Offset = i * ADDRESS_SPACING;
+        SampleBlocks[i].Toggles = 0;
+    }
+    
+#ifndef FIXED_SAMPLE_LOCATIONS
+    SetDom1Speed(SAMPLE_SCAN_LAT, SAMPLE_SCAN_PWD, 0x07, 0x03);
+    CartRomSize = CartDetectRomSize();
+    CartDom1Stream(0, CartRomSize, SampleScanCallback, NULL);
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    
+    debugf("ROM size: %luKB\n", (unsigned long)(CartRomSize / 1024));
+    for (int i = 0; i < NUM_TEST_LOCATIONS; i++) {
+        debugf("Sample %d: offset 0x%06lX, %lu toggles\n", i,
+               (unsigned long)SampleBlocks[i].Offset, (unsigned long)SampleBlocks[i].Toggles);
+    }
+#endif
+}
+
+/**
+ * @brief Drop any cached copy of the uncached DMA targets
+ *
+ * ProbeArena, DetectWords and Dom2Arena are only accessed through KSEG1 afterwards, so no
+ * cache line can cover them again and probes need no cache maintenance.
+ */
+void ProbeArenaInit(void) {
+    data_cache_hit_writeback_invalidate(ProbeArena, sizeof(ProbeArena));
+    data_cache_hit_writeback_invalidate(DetectWords, sizeof(DetectWords));
+    data_cache_hit_writeback_invalidate(Dom2Arena, sizeof(Dom2Arena));
+}
+
+/**
+ * @brief Group the sample blocks into spans of adjacent blocks
+ *
+ * Each span costs one PI DMA setup per probe instead of one per block. Blocks
+ * with a gap between them stay separate, since reading the gap costs more bus
+ * time than a DMA setup.
+ */
+static void PlanProbeSpans(void) {
+    uint32_t Offsets[NUM_TEST_LOCATIONS];
+    
+    // Sort the block offsets (insertion sort, NUM_TEST_LOCATIONS is small)
+    for (int i = 0; i < NUM_TEST_LOCATIONS; i++) {
+        int j = i;
+        while (j > 0 && Offsets[j - 1] > SampleBlocks[i].Offset) {
+            Offsets[j] = Offsets[j - 1];
+            j--;
+        }
+        Offsets[j] = SampleBlocks[i].Offset;
+    }
+    
+    NumProbeSpans = 0;
+    uint32_t ArenaOffset = 0;
+    for (int i = 0; i < NUM_TEST_LOCATIONS; i++) {
+        probe_span_t * Last = (NumProbeSpans > 0) ? &ProbeSpans[NumProbeSpans - 1] : NULL;
+        if (Last != NULL && Offsets[i] < Last->Offset + Last->Len) {
+            // Same block selected twice (e.g. a tiny ROM), already covered
             continue;
+        }
+        if (Last != NULL && Offsets[i] == Last->Offset + Last->Len) {
+            Last->Len += BYTES_PER_LOCATION;
         } else {
-            // Doesn't match open bus - cartridge likely present
-            return true;
+            ProbeSpans[NumProbeSpans].Offset = Offsets[i];
+            ProbeSpans[NumProbeSpans].Len = BYTES_PER_LOCATION;
+            ProbeSpans[NumProbeSpans].ArenaOffset = ArenaOffset;
+            NumProbeSpans++;
+        }
+        ArenaOffset += BYTES_PER_LOCATION;
+    }
+    
+    debugf("Probe: %d DMA(s) for %d sample blocks\n", NumProbeSpans, NUM_TEST_LOCATIONS);
+}
+
+/**
+ * @brief Append a DMA to the probe spans, moved back if it would run past the end of Domain 1
+ */
+static void AddProbeSpan(uint32_t Offset, uint32_t Len, uint32_t * ArenaOffset) {
+    assert(NumProbeSpans < MAX_PROBE_SPANS);
+    assert(*ArenaOffset + Len <= PROBE_ARENA_SIZE);
+    
+    if (Offset + Len > CART_DOM1_SIZE) {
+        Offset = (CART_DOM1_SIZE - Len) & ~1u;
+    }
+    ProbeSpans[NumProbeSpans].Offset = Offset;
+    ProbeSpans[NumProbeSpans].Len = Len;
+    ProbeSpans[NumProbeSpans].ArenaOffset = *ArenaOffset;
+    NumProbeSpans++;
+    *ArenaOffset += ((Len + 15) & ~15u) + PROBE_SPAN_PADDING;
+}
+
+/**
+ * @brief Append short DMAs that start just before a page boundary near Base
+ *
+ * The boundary is TRANSFER_PAGE_ALIGN aligned, so it is a page boundary for every PGS.
+ */
+static void AddPageCrossSpans(uint32_t Base, uint32_t * ArenaOffset) {
+    uint32_t Boundary = (Base + TRANSFER_PAGE_ALIGN) & ~(TRANSFER_PAGE_ALIGN - 1);
+    if (Boundary >= CART_DOM1_SIZE) {
+        Boundary -= TRANSFER_PAGE_ALIGN;
+    }
+    AddProbeSpan(Boundary - 2, 4, ArenaOffset);
+    AddProbeSpan(Boundary - 8, 16, ArenaOffset);
+    AddProbeSpan(Boundary - 64, 128, ArenaOffset);
+    AddProbeSpan(Boundary - 512, 2048, ArenaOffset);
+}
+
+/**
+ * @brief Plan the probe spans of a transfer profile
+ *
+ * Profiles other than the samples start at the sample block with the most
+ * data-line toggles. Cart offsets stay even (the PI needs that), arena
+ * positions stay 16-byte aligned.
+ */
+static void PlanTransferSpans(transfer_profile_t Profile) {
+    uint32_t Base = SampleBlocks[0].Offset;
+    uint32_t ArenaOffset = 0;
+    
+    if (Profile == TRANSFER_SAMPLES) {
+        PlanProbeSpans();
+        return;
+    }
+    if (Profile == TRANSFER_TIMING_SEARCH) {
+        PlanProbeSpans();
+        const probe_span_t * Last = &ProbeSpans[NumProbeSpans - 1];
+        ArenaOffset = Last->ArenaOffset + Last->Len;
+        AddPageCrossSpans(Base, &ArenaOffset);
+        return;
+    }
+    
+    NumProbeSpans = 0;
+    switch (Profile) {
+        case TRANSFER_SIZES:
+            for (uint32_t Len = 2; Len <= 0x8000; Len *= 4) {
+                AddProbeSpan(Base, Len, &ArenaOffset);
+            }
+            break;
+        
+        case TRANSFER_BURST:
+            AddProbeSpan(Base, BENCH_TRANSFER_SIZE, &ArenaOffset);
+            break;
+        
+        case TRANSFER_PAGE_CROSS:
+            AddPageCrossSpans(Base, &ArenaOffset);
+            break;
+        
+        case TRANSFER_ODD:
+            AddProbeSpan(Base, 1, &ArenaOffset);
+            AddProbeSpan(Base + 2, 3, &ArenaOffset);
+            AddProbeSpan(Base + 4, 13, &ArenaOffset);
+            AddProbeSpan(Base + 6, 127, &ArenaOffset);
+            AddProbeSpan(Base + 10, 129, &ArenaOffset);
+            AddProbeSpan(Base + 2, 1021, &ArenaOffset);
+            break;
+        
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Read reference data at slowest speed
+ */
+void ReadReferenceData(void) {
+    PROFILE_BEGIN(Start);
+    
+    PlanTransferSpans(ActiveTransferProfile);
+    
+    // Set to slowest speed
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    
+    // One DMA per span, invalidated once for the whole batch
+    PROFILE_BEGIN(FlushStart);
+    data_cache_hit_invalidate(ReferenceData, sizeof(ReferenceData));
+    PROFILE_END(PROFILE_CACHE, FlushStart);
+    for (int i = 0; i < NumProbeSpans; i++) {
+        CartDom1ReadAsync(ReferenceData + ProbeSpans[i].ArenaOffset, ProbeSpans[i].Offset, ProbeSpans[i].Len);
+    }
+    PiDmaWaitIdle();
+    PROFILE_BEGIN(CacheStart);
+    data_cache_hit_invalidate(ReferenceData, sizeof(ReferenceData));
+    PROFILE_END(PROFILE_CACHE, CacheStart);
+    
+    PROFILE_END(PROFILE_REFERENCE, Start);
+}
+
+#ifdef DMA_LATENCY
+/**
+ * @brief Measure the fixed cost of a DMA at slowest speed, so probe timings only show bus time
+ *
+ * Times a short and a long read from the start of the ROM (page aligned) and
+ * keeps the fastest of each.
+ */
+static void CalibrateDmaLatency(void) {
+    const uint32_t Lengths[2] = { LATENCY_CAL_SHORT, LATENCY_CAL_LONG };
+    uint32_t Fastest[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+    
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    data_cache_hit_writeback_invalidate(BenchBuffer, LATENCY_CAL_LONG);
+    for (int Repeat = 0; Repeat < LATENCY_CAL_REPEATS; Repeat++) {
+        for (int i = 0; i < 2; i++) {
+            uint32_t Ticket = CartDom1ReadAsync(BenchBuffer, 0, Lengths[i]);
+            PiDmaWait(Ticket);
+            uint32_t Ticks = PiDmaTransferTicks(Ticket);
+            if (Ticks < Fastest[i]) {
+                Fastest[i] = Ticks;
+            }
         }
     }
     
-    // All addresses matched open bus pattern
-    return false;
+    PiLatencyCalibrate(0xFF, 0xFF, 0x07, 0x03, Lengths[0], Fastest[0], Lengths[1], Fastest[1]);
+}
+
+/**
+ * @brief Compare the timed probes at each LAT's minimum PWD with the timing model
+ */
+static void SummarizeDmaLatency(void) {
+    PiLatencySummarize(MinPWDForLAT, 0x07, 0x03, LatencyNs, LatencyMismatch, &LatencySummary);
+    for (int LAT = 0; LAT < 256; LAT++) {
+        uint32_t Tens = (LatencyNs[LAT] + 5) / 10;
+        LatencyTensOfNs[LAT] = (LatencyNs[LAT] == 0xFFFF) ? 0xFF : (Tens < 0xFF) ? (uint8_t)Tens : 0xFE;
+    }
+    
+    PiLatencyReport();
+    debugf("DMA latency: cart %s, %ld/16 cycles per halfword off the model, slope %ld%%, %d of %d cells off\n",
+           PiLatencyVerdictName(LatencySummary.Verdict), (long)LatencySummary.Offset16,
+           (long)LatencySummary.SlopePercent, LatencySummary.Mismatched, LatencySummary.Cells);
+}
+#endif
+
+#ifdef RSP_VERIFY
+/**
+ * @brief Compare the probe spans on the RSP, posting each as soon as its DMA completes
+ * @param Tickets DMA tickets of the spans
+ * @param OutWorks Set to whether every span matched the reference
+ * @return false if the RSP stopped answering (the spans are then compared on the CPU)
+ */
+static bool CompareSpansOnRsp(const uint32_t * Tickets, bool * OutWorks) {
+    int32_t Jobs[MAX_PROBE_SPANS];
+    
+    for (int i = 0; i < NumProbeSpans; i++) {
+        const probe_span_t * Span = &ProbeSpans[i];
+        
+        PROFILE_BEGIN(WaitStart);
+        PiDmaWait(Tickets[i]);
+        PROFILE_END(PROFILE_DMA_WAIT, WaitStart);
+        
+        Jobs[i] = RspVerifyPostCompare(ProbeArena + Span->ArenaOffset, ReferenceData + Span->ArenaOffset, Span->Len);
+        if (Jobs[i] < 0) {
+            return false;
+        }
+    }
+    
+    PROFILE_BEGIN(CompareStart);
+    bool Answered = true;
+    *OutWorks = true;
+    for (int i = 0; i < NumProbeSpans && *OutWorks; i++) {
+        Answered = RspVerifyWait(Jobs[i]);
+        if (!Answered) {
+            break;
+        }
+        uint16_t Lanes = RspVerifyLanes(Jobs[i]);
+        if (Lanes != 0) {
+            LastProbeLanes = Lanes;
+            *OutWorks = false;
+        }
+    }
+    PROFILE_END(PROFILE_COMPARE, CompareStart);
+    return Answered;
+}
+#endif
+
+/**
+ * @brief RomCompareLanes for any length; bytes past the last multiple of 16 are compared one by one
+ */
+static uint32_t CompareSpanLanes(const uint8_t * Data, const uint8_t * Reference, uint32_t Len, uint16_t * OutLanes) {
+    uint32_t Bulk = Len & ~15u;
+    uint32_t Errors = 0;
+    
+    *OutLanes = 0;
+    if (Bulk > 0) {
+        Errors = RomCompareLanes(Data, Reference, Bulk, OutLanes);
+    }
+    for (uint32_t i = Bulk; i < Len; i++) {
+        uint8_t Diff = Data[i] ^ Reference[i];
+        if (Diff != 0) {
+            // Spans start at even offsets: even bytes travel on AD15-AD8, odd bytes on AD7-AD0
+            *OutLanes |= (i & 1) ? Diff : (uint16_t)(Diff << 8);
+            Errors++;
+        }
+    }
+    return Errors;
+}
+
+/**
+ * @brief Time RomCompareLanes against memcmp on one probe's worth of sample data
+ *
+ * The data is read from the probe arena through KSEG1 and the reference from
+ * the cache, as in TestSpeed. Contents do not matter for the timing, so the
+ * arena and the reference are filled with a pattern; both are reloaded before
+ * the first probe.
+ */
+void MeasureCompareKernel(void) {
+    const uint32_t Len = NUM_TEST_LOCATIONS * BYTES_PER_LOCATION;
+    uint8_t * Data = UncachedAddr(ProbeArena);
+    uint32_t Ticks[2][2];  // [mismatch][RomCompareLanes, memcmp]
+    
+    for (uint32_t i = 0; i < Len; i++) {
+        Data[i] = ReferenceData[i] = (uint8_t)(i * 0x5B);
+    }
+    for (int Mismatch = 0; Mismatch < 2; Mismatch++) {
+        Data[0] = ReferenceData[0] ^ (Mismatch ? 0x80 : 0x00);
+        Ticks[Mismatch][0] = Ticks[Mismatch][1] = 0;
+        for (int i = 0; i < COMPARE_BENCH_REPEATS; i++) {
+            uint16_t Lanes;
+            uint32_t Start = C0_COUNT();
+            RomCompareLanes(Data, ReferenceData, Len, &Lanes);
+            uint32_t Middle = C0_COUNT();
+            volatile int Result = memcmp(Data, ReferenceData, Len);
+            (void)Result;
+            Ticks[Mismatch][0] += Middle - Start;
+            Ticks[Mismatch][1] += C0_COUNT() - Middle;
+        }
+    }
+    
+    // CPU cycles are twice the C0 COUNT ticks
+    CompareBench.LanesMatch = Ticks[0][0] * 2 / COMPARE_BENCH_REPEATS;
+    CompareBench.MemcmpMatch = Ticks[0][1] * 2 / COMPARE_BENCH_REPEATS;
+    CompareBench.LanesMismatch = Ticks[1][0] * 2 / COMPARE_BENCH_REPEATS;
+    CompareBench.MemcmpMismatch = Ticks[1][1] * 2 / COMPARE_BENCH_REPEATS;
+    debugf("Compare %luB: RomCompareLanes %lu/%lu cycles, memcmp %lu/%lu cycles (match/mismatch)\n",
+           (unsigned long)Len, (unsigned long)CompareBench.LanesMatch, (unsigned long)CompareBench.LanesMismatch,
+           (unsigned long)CompareBench.MemcmpMatch, (unsigned long)CompareBench.MemcmpMismatch);
+}
+
+/**
+ * @brief Probe with another transfer profile from now on and read its reference data
+ */
+void SelectTransferProfile(transfer_profile_t Profile) {
+    ActiveTransferProfile = Profile;
+    ReadReferenceData();
+}
+
+/**
+ * @brief Test a specific LAT/PWD/PGS/RLS speed combination
+ *
+ * Issues the DMAs of the active transfer profile and compares them with the
+ * same DMAs read at slowest speed.
+ */
+bool TestSpeed(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    PROFILE_BEGIN(ProbeStart);
+    uint32_t ProbeBegin = C0_COUNT();
+
+    // Set speed
+    PROFILE_BEGIN(SetStart);
+    SetDom1Speed(LAT, PWD, PGS, RLS);
+    PROFILE_END(PROFILE_SET_SPEED, SetStart);
+    
+    // Queue every span at once and compare each as soon as its DMA completes.
+    // ProbeArena is read through KSEG1, so there is no cache maintenance per probe.
+    const uint8_t * Arena = UncachedAddr(ProbeArena);
+    uint32_t Tickets[MAX_PROBE_SPANS];
+    bool Works = true;
+    bool Compared = false;
+    
+    for (int i = 0; i < NumProbeSpans; i++) {
+        Tickets[i] = CartDom1ReadAsync(ProbeArena + ProbeSpans[i].ArenaOffset, ProbeSpans[i].Offset, ProbeSpans[i].Len);
+    }
+    
+#ifdef RSP_VERIFY
+    // The RSP compares whole 16-byte rows, which only the sample spans are made of
+    if (ActiveTransferProfile == TRANSFER_SAMPLES) {
+        Compared = CompareSpansOnRsp(Tickets, &Works);
+    }
+#endif
+    for (int i = 0; i < NumProbeSpans && !Compared; i++) {
+        const probe_span_t * Span = &ProbeSpans[i];
+        
+        PROFILE_BEGIN(WaitStart);
+        PiDmaWait(Tickets[i]);
+        PROFILE_END(PROFILE_DMA_WAIT, WaitStart);
+        
+        // Compare with reference data (read at slowest speed)
+        PROFILE_BEGIN(CompareStart);
+        uint16_t Lanes;
+        uint32_t Errors = CompareSpanLanes(Arena + Span->ArenaOffset, ReferenceData + Span->ArenaOffset, Span->Len, &Lanes);
+        Works = (Errors == 0);
+        PROFILE_END(PROFILE_COMPARE, CompareStart);
+        if (!Works) {
+            // Later spans may still be on the bus; SetDom1Speed waits for them
+            // before the next probe touches the arena or the timing registers
+            LastProbeLanes = Lanes;
+            break;
+        }
+    }
+    
+#ifdef DMA_LATENCY
+    // Spans still on the bus after an early mismatch are not timed
+    for (int i = 0; i < NumProbeSpans && !ProbesUncounted; i++) {
+        if (PiDmaIsDone(Tickets[i])) {
+            PiLatencyRecord(LAT, PWD, PGS, RLS, ProbeSpans[i].Offset, ProbeSpans[i].Len, PiDmaTransferTicks(Tickets[i]));
+        }
+    }
+#endif
+    
+    if (!ProbesUncounted) {
+        ProbeCount++;
+        ProbeTicks += C0_COUNT() - ProbeBegin;
+    }
+    PROFILE_END(PROFILE_TEST_SPEED, ProbeStart);
+    return Works;
+}
+
+/**
+ * @brief Test a combination through CPU loads instead of DMA
+ *
+ * Reads the sample blocks with 32-bit uncached loads (io_read) and compares
+ * them with the reference data. Every PIO load pays the full access latency,
+ * so a timing can pass DMA and still break games that read the ROM directly.
+ */
+bool TestSpeedPio(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    if (!ProbesUncounted) {
+        PioProbeCount++;
+    }
+    SetDom1Speed(LAT, PWD, PGS, RLS);
+    
+    for (int i = 0; i < NumProbeSpans; i++) {
+        const probe_span_t * Span = &ProbeSpans[i];
+        uint32_t Diff = 0;
+        for (uint32_t Position = 0; Position < Span->Len; Position += 4) {
+            uint32_t Word = io_read(CART_DOM1_START + Span->Offset + Position);
+            Diff |= Word ^ RomReadWord(ReferenceData + Span->ArenaOffset + Position);
+        }
+        if (Diff != 0) {
+            LastProbeLanes = (uint16_t)(Diff | (Diff >> 16));
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief TestSpeed as a pi_bus_t probe
+ */
+static bool BusProbeDma(void * Context, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    if (TestSpeed(LAT, PWD, PGS, RLS)) {
+        return true;
+    }
+    *OutLanes = LastProbeLanes;
+    return false;
+}
+
+/**
+ * @brief TestSpeedPio as a pi_bus_t probe
+ */
+static bool BusProbePio(void * Context, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    if (TestSpeedPio(LAT, PWD, PGS, RLS)) {
+        return true;
+    }
+    *OutLanes = LastProbeLanes;
+    return false;
+}
+
+// Domain 1 read paths as seen by the search strategies in pisweep.c
+static const pi_bus_t Dom1DmaBus = { BusProbeDma, BusReadDom1Words, NULL };
+static const pi_bus_t Dom1PioBus = { BusProbePio, BusReadDom1Words, NULL };
+
+/**
+ * @brief Mark each LAT in the matrix as the sweep decides it
+ */
+static void SweepProgress(void * Context, int LAT) {
+    MatrixViewMarkCell(LAT);
+    MatrixViewPresent(false);
+}
+
+/**
+ * @brief Map a timing to a speed level by its predicted throughput relative to retail
+ */
+speed_level_t MapSpeedToLevel(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    uint32_t Percent = PiModelPercentOfRetail(LAT, PWD, PGS, RLS, MODEL_WORKLOAD_SIZE);
+    
+    speed_level_t Level = SPEED_LEVEL_TOTAL_POS;
+    while (Level + 1 < NUM_SPEED_LEVELS && Percent >= SpeedLevelMinPercent[Level + 1]) {
+        Level++;
+    }
+    return Level;
+}
+
+/**
+ * @brief Predicted time of a MODEL_WORKLOAD_SIZE transfer at a frontier point (lower is better)
+ *
+ * The model prediction is scaled by how far the point's measured throughput was
+ * from its predicted throughput, so for a workload the size of the benchmark
+ * transfers this ranks by measured throughput.
+ */
+static uint64_t PredictWorkloadCost(const frontier_point_t * Point) {
+    uint64_t Cycles = PiModelCycles(Point->LAT, Point->PWD, Point->PGS, Point->RLS, MODEL_WORKLOAD_SIZE);
+    if (Point->KBPerSec == 0) {
+        return Cycles;
+    }
+    return Cycles * Point->PredictedKBPerSec / Point->KBPerSec;
+}
+
+#ifdef MARGIN_TEST
+/**
+ * @brief Decide whether a combination is reliable with a sequential probability ratio test
+ *
+ * Each TestSpeed call is one trial. The log-likelihood ratio of "fails at
+ * MARGIN_P1_PPM" against "fails at MARGIN_P0_PPM" is updated after every probe,
+ * so a cell that fails outright is rejected after a couple of probes and only
+ * cells that fail rarely need long runs. Every probe comes out of the sweep's
+ * MARGIN_PROBE_BUDGET; once it is spent, cells are rejected without probing.
+ * @return true if the failure rate is below MARGIN_P0_PPM, false otherwise (or undecided)
+ */
+static bool MarginTestCell(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    const float P0 = MARGIN_P0_PPM / 1000000.0f;
+    const float P1 = MARGIN_P1_PPM / 1000000.0f;
+    const float FailWeight = logf(P1 / P0);
+    const float PassWeight = logf((1.0f - P1) / (1.0f - P0));
+    const float AcceptBound = logf(MARGIN_BETA / (1.0f - MARGIN_ALPHA));
+    const float RejectBound = logf((1.0f - MARGIN_BETA) / MARGIN_ALPHA);
+    
+    float LogRatio = 0.0f;
+    for (int Probe = 0; Probe < MARGIN_MAX_PROBES; Probe++) {
+        if (MarginProbes >= MARGIN_PROBE_BUDGET) {
+            MarginBudgetHit = true;
+            return false;
+        }
+        MarginProbes++;
+        LogRatio += TestSpeed(LAT, PWD, PGS, RLS) ? PassWeight : FailWeight;
+        if (LogRatio <= AcceptBound) {
+            return true;
+        }
+        if (LogRatio >= RejectBound) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Margin test one cell (pi_bus_t Probe)
+ */
+static bool BusProbeMargin(void * Context, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    bool Reliable = MarginTestCell(LAT, PWD, PGS, RLS);
+    *OutLanes = Reliable ? 0 : LastProbeLanes;
+    return Reliable;
+}
+
+static const pi_bus_t Dom1MarginBus = { BusProbeMargin, BusReadDom1Words, NULL };
+
+/**
+ * @brief Add the guard band to a reliable PWD
+ */
+static uint8_t AddMarginGuard(uint8_t ReliablePWD) {
+    if (ReliablePWD == 0xFF) {
+        return 0xFF;
+    }
+    return (uint8_t)((ReliablePWD + MARGIN_GUARD_PWD < 0xFF) ? ReliablePWD + MARGIN_GUARD_PWD : 0xFE);
+}
+
+/**
+ * @brief Find the lowest reliable PWD at a LAT, starting from its single-pass minimum
+ * @return Reliable PWD plus MARGIN_GUARD_PWD (capped at 0xFE), 0xFF if none is reliable
+ */
+static uint8_t FindSafePWD(uint8_t LAT, uint8_t MinPWD, uint8_t PGS, uint8_t RLS) {
+    return AddMarginGuard(PiSweepRaisePWD(&Dom1MarginBus, LAT, MinPWD, PGS, RLS));
+}
+
+/**
+ * @brief Fill SafePWDForLAT from the single-pass MinPWDForLAT frontier
+ *
+ * The frontier is raised with the margin test as the probe, so each LAT
+ * usually costs one accepted cell. Starts the sweep's MARGIN_PROBE_BUDGET.
+ */
+void RunMarginTest(void) {
+    uint8_t ReliablePWDForLAT[256];
+    
+    MarginProbes = 0;
+    MarginBudgetHit = false;
+    PiSweepRaise(&Dom1MarginBus, 0x07, 0x03, MinPWDForLAT, ReliablePWDForLAT, NULL, NULL);
+    
+    MarginalLATCount = 0;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        SafePWDForLAT[LAT] = AddMarginGuard(ReliablePWDForLAT[LAT]);
+        MarginalLAT[LAT] = (ReliablePWDForLAT[LAT] != 0xFF && ReliablePWDForLAT[LAT] > MinPWDForLAT[LAT]);
+        if (MarginalLAT[LAT]) {
+            MarginalLATCount++;
+        }
+    }
+    
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    
+    // Raw and safe tables side by side, one row of 16 LATs per line
+    debugf("Margin: %d LAT(s) with marginal single-pass minimum, guard band +%d, %lu probes\n",
+           MarginalLATCount, MARGIN_GUARD_PWD, (unsigned long)MarginProbes);
+    if (MarginBudgetHit) {
+        debugf("Margin: probe budget of %d spent, untested LATs have no safe PWD\n", MARGIN_PROBE_BUDGET);
+    }
+    for (int Row = 0; Row < 16; Row++) {
+        debugf("LAT %02X:", Row * 16);
+        for (int Col = 0; Col < 16; Col++) {
+            debugf(" %02X/%02X", MinPWDForLAT[Row * 16 + Col], SafePWDForLAT[Row * 16 + Col]);
+        }
+        debugf("\n");
+    }
+}
+#endif
+
+/**
+ * @brief Start a DMA from Domain 2 (save memory)
+ * @return Ticket for PiDmaWait
+ */
+uint32_t CartDom2ReadAsync(void * Dest, uint32_t Offset, uint32_t Len) {
+    assert(Dest != NULL);
+    assert(Len > 0);
+    assert(Offset + Len <= CART_DOM2_SIZE);
+
+    return PiDmaRead(Dest, Offset | CART_DOM2_START, Len);
+}
+
+/**
+ * @brief Test a Domain 2 combination against the save memory reference
+ */
+bool TestSpeedDom2(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    SetDomSpeed(PI_DOMAIN_2, LAT, PWD, PGS, RLS);
+    PiDmaWait(CartDom2ReadAsync(Dom2Arena, Dom2SampleOffset, DOM2_SAMPLE_SIZE));
+    
+    uint16_t Lanes;
+    if (RomCompareLanes(UncachedAddr(Dom2Arena), Dom2Reference, DOM2_SAMPLE_SIZE, &Lanes) != 0) {
+        LastProbeLanes = Lanes;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief TestSpeedDom2 as a pi_bus_t probe
+ */
+static bool BusProbeDom2(void * Context, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    if (TestSpeedDom2(LAT, PWD, PGS, RLS)) {
+        return true;
+    }
+    *OutLanes = LastProbeLanes;
+    return false;
+}
+
+// Save memory as seen by the search strategies (presence is checked by ReadDom2Reference)
+static const pi_bus_t Dom2Bus = { BusProbeDom2, NULL, NULL };
+
+/**
+ * @brief Identify the save memory from reads alone, putting a FlashRAM into read-array mode
+ *
+ * A FlashRAM left in status or ID mode answers every read with that register
+ * instead of the save, so it needs the read-array command at DOM2_FLASH_COMMAND
+ * first. An SRAM would take the command as a write to a save word, so it is
+ * only sent when the first word is the FlashRAM silicon ID. Any other save must
+ * already read as data: if its first words only repeat one or two values (a
+ * status register, or a blank SRAM), it cannot be told apart without a write
+ * and is left alone.
+ * @return false if the save could not be identified
+ */
+static bool Dom2IdentifySave(void) {
+    uint32_t Words[DOM2_ID_WORDS];
+    bool Repeating = true;
+    
+    for (int i = 0; i < DOM2_ID_WORDS; i++) {
+        Words[i] = io_read(CART_DOM2_START + i * 4);
+        Repeating = Repeating && (Words[i] == Words[i & 1]);
+    }
+    if (!Repeating) {
+        return true;
+    }
+    if (Words[0] != DOM2_FLASH_ID) {
+        return false;
+    }
+    
+    io_write(CART_DOM2_START + DOM2_FLASH_COMMAND, DOM2_FLASH_READ_ARRAY);
+    return true;
+}
+
+/**
+ * @brief Read the Domain 2 reference at slowest speed
+ *
+ * The whole save is read once and the DOM2_SAMPLE_SIZE window with the most
+ * data-line toggles becomes the reference. Dom2Pattern is set if every AD line
+ * takes both values in that window; a blank save (all 0x00 or all 0xFF) has no
+ * such window and would pass at any timing. A save Dom2IdentifySave cannot
+ * identify is not read further and Dom2Identified stays false.
+ * @return false if nothing answers (open bus) or a second slow read differs
+ */
+bool ReadDom2Reference(void) {
+    SetDomSpeed(PI_DOMAIN_2, 0xFF, 0xFF, DOM2_DEFAULT_PGS, 0x03);
+    
+    // Open bus returns the lower 16 bits of the address, as on Domain 1. Single
+    // reads of words 0 and 2, since a DMA burst repeats its start address
+    bool OpenBus = true;
+    for (uint32_t Position = 0; Position < 16 && OpenBus; Position += 8) {
+        OpenBus = PiSweepWordIsOpenBus(CART_DOM2_START + Position, io_read(CART_DOM2_START + Position));
+    }
+    if (OpenBus) {
+        return false;
+    }
+    
+    Dom2Identified = Dom2IdentifySave();
+    if (!Dom2Identified) {
+        return true;
+    }
+    
+    data_cache_hit_invalidate(BenchBuffer, CART_DOM2_SIZE);
+    PiDmaWait(CartDom2ReadAsync(BenchBuffer, 0, CART_DOM2_SIZE));
+    data_cache_hit_invalidate(BenchBuffer, CART_DOM2_SIZE);
+    
+    uint32_t BestToggles = 0;
+    Dom2SampleOffset = 0;
+    for (uint32_t Offset = 0; Offset < CART_DOM2_SIZE; Offset += DOM2_SAMPLE_SIZE) {
+        uint32_t Toggles = RomToggleDensity(BenchBuffer + Offset, DOM2_SAMPLE_SIZE);
+        if (Toggles > BestToggles) {
+            BestToggles = Toggles;
+            Dom2SampleOffset = Offset;
+        }
+    }
+    memcpy(Dom2Reference, BenchBuffer + Dom2SampleOffset, DOM2_SAMPLE_SIZE);
+    
+    uint16_t Ones = 0;
+    uint16_t Zeros = 0;
+    for (uint32_t Position = 0; Position < DOM2_SAMPLE_SIZE; Position += 2) {
+        uint16_t Halfword = (uint16_t)((Dom2Reference[Position] << 8) | Dom2Reference[Position + 1]);
+        Ones |= Halfword;
+        Zeros |= (uint16_t)~Halfword;
+    }
+    Dom2Pattern = ((Ones & Zeros) == 0xFFFF);
+    
+    return TestSpeedDom2(0xFF, 0xFF, DOM2_DEFAULT_PGS, 0x03);
+}
+
+// Regions the throughput benchmark reads
+static const bench_target_t Dom1Bench = { PI_DOMAIN_1, CartDom1ReadAsync, BENCH_TRANSFER_SIZE, NULL };
+static const bench_target_t Dom2Bench = { PI_DOMAIN_2, CartDom2ReadAsync, DOM2_BENCH_SIZE, NULL };
+
+/**
+ * @brief Measure sustained throughput at a LAT/PWD/PGS/RLS combination
+ *
+ * Times large DMAs with the C0 COUNT register, so the result includes the
+ * per-transfer setup cost a real loader would pay.
+ * @param Target Domain and region to time (Dom1Bench, Dom2Bench)
+ * @param Repeats Number of Target->Len DMAs to time
+ * @return Throughput in KB/s (1 KB = 1000 bytes)
+ */
+uint32_t MeasureThroughput(const bench_target_t * Target, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, int Repeats) {
+    SetDomSpeed(Target->Domain, LAT, PWD, PGS, RLS);
+    data_cache_hit_invalidate(BenchBuffer, Target->Len);
+    
+    uint32_t Ticks = 0;
+    for (int i = 0; i < Repeats; i++) {
+        if (Target->BeforeDma != NULL) {
+            Target->BeforeDma();
+        }
+        uint32_t Start = C0_COUNT();
+        PiDmaWait(Target->StartDma(BenchBuffer, 0, Target->Len));
+        Ticks += C0_COUNT() - Start;
+    }
+    
+    if (Ticks == 0) {
+        return 0;
+    }
+    uint64_t Bytes = (uint64_t)Target->Len * Repeats;
+    return (uint32_t)(Bytes * TICKS_PER_SECOND / Ticks / 1000);
+}
+
+/**
+ * @brief Sweep the Domain 2 (save memory) LAT/PWD frontier, read-only
+ *
+ * Same frontier walk as Domain 1, at the common SRAM PGS/RLS, drawn live in
+ * the matrix. The corner the timing model predicts fastest for a whole-save
+ * read is then measured next to the common timing.
+ */
+void RunDom2Test(void) {
+    memset(Dom2MinPWDForLAT, 0xFF, sizeof(Dom2MinPWDForLAT));
+    Dom2BestLAT = 0xFF;
+    Dom2BestPWD = 0xFF;
+    Dom2KBPerSec = 0;
+    Dom2DefaultKBPerSec = 0;
+    
+    MatrixViewSetTable(Dom2MinPWDForLAT, NULL);
+    MatrixViewClearText();
+    MatrixViewPrintf("Domain 2 (save memory)...\n");
+    MatrixViewPresent(true);
+    
+    Dom2Pattern = false;
+    Dom2Identified = false;
+    Dom2Present = ReadDom2Reference();
+    if (!Dom2Present) {
+        debugf("Domain 2: no save memory answered at 0x%08X\n", CART_DOM2_START);
+        SetDomSpeed(PI_DOMAIN_2, DOM2_DEFAULT_LAT, DOM2_DEFAULT_PWD, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS);
+        return;
+    }
+    if (!Dom2Identified) {
+        // A FlashRAM register and a blank SRAM read alike, and only the FlashRAM may be sent a command
+        debugf("Domain 2: save not identified without a write, not swept\n");
+        SetDomSpeed(PI_DOMAIN_2, DOM2_DEFAULT_LAT, DOM2_DEFAULT_PWD, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS);
+        return;
+    }
+    if (!Dom2Pattern) {
+        // AD lines that never change cannot show a timing error, so every cell would pass
+        debugf("Domain 2: no usable pattern in the save, not swept\n");
+        SetDomSpeed(PI_DOMAIN_2, DOM2_DEFAULT_LAT, DOM2_DEFAULT_PWD, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS);
+        return;
+    }
+    
+    PiSweepRun(&Dom2Bus, PI_SWEEP_FRONTIER, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS, Dom2MinPWDForLAT,
+               NULL, NULL, SweepProgress, NULL);
+    
+    // Fastest frontier cell for a whole-save read according to the timing model
+    uint32_t BestCycles = 0;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        uint8_t PWD = Dom2MinPWDForLAT[LAT];
+        if (PWD == 0xFF) {
+            continue;
+        }
+        uint32_t Cycles = PiModelCycles((uint8_t)LAT, PWD, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS, DOM2_BENCH_SIZE);
+        if (Dom2BestLAT == 0xFF || Cycles < BestCycles) {
+            Dom2BestLAT = (uint8_t)LAT;
+            Dom2BestPWD = PWD;
+            BestCycles = Cycles;
+        }
+    }
+    
+    if (Dom2BestLAT != 0xFF) {
+        Dom2KBPerSec = MeasureThroughput(&Dom2Bench, Dom2BestLAT, Dom2BestPWD, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS,
+                                         BENCH_REPEATS);
+    }
+    Dom2DefaultKBPerSec = MeasureThroughput(&Dom2Bench, DOM2_DEFAULT_LAT, DOM2_DEFAULT_PWD, DOM2_DEFAULT_PGS,
+                                            DOM2_DEFAULT_RLS, BENCH_REPEATS);
+    SetDomSpeed(PI_DOMAIN_2, DOM2_DEFAULT_LAT, DOM2_DEFAULT_PWD, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS);
+    
+    debugf("Domain 2: LAT=0x%02X PWD=0x%02X PGS=0x%X RLS=0x%X %lu KB/s, common timing %lu KB/s\n",
+           Dom2BestLAT, Dom2BestPWD, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS,
+           (unsigned long)Dom2KBPerSec, (unsigned long)Dom2DefaultKBPerSec);
+}
+
+#ifdef WRITE_TEST
+/**
+ * @brief Queue a write to Domain 1 without waiting for it
+ * @param Address PI address, may be past the 8MB ROM window (e.g. the ISViewer buffer)
+ * @return Ticket for PiDmaWait
+ */
+uint32_t CartDom1WriteAsync(void * Src, uint32_t Address, uint32_t Len) {
+    assert(Src != NULL);
+    assert(Len > 0);
+    assert(Address >= CART_DOM1_START && Address + Len <= 0x1FC00000);
+
+    return PiDmaWrite(Src, Address, Len);
+}
+
+/**
+ * @brief Read the write region back at slowest speed into WriteArena
+ */
+static void ReadBackWriteRegion(void) {
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    PiDmaWait(PiDmaRead(WriteArena, WRITE_REGION_START, WRITE_TEST_SIZE));
+}
+
+/**
+ * @brief Write a pattern at a combination and check it by reading it back at slowest speed
+ *
+ * Probes alternate between two complementary patterns, so data left in the
+ * region by the previous probe never matches.
+ */
+bool TestSpeedWrite(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    uint8_t * Pattern = WritePatterns[WriteProbeCount++ & 1];
+    
+    SetDom1Speed(LAT, PWD, PGS, RLS);
+    PiDmaWait(CartDom1WriteAsync(Pattern, WRITE_REGION_START, WRITE_TEST_SIZE));
+    ReadBackWriteRegion();
+    
+    uint16_t Lanes;
+    if (RomCompareLanes(UncachedAddr(WriteArena), Pattern, WRITE_TEST_SIZE, &Lanes) != 0) {
+        LastProbeLanes = Lanes;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief TestSpeedWrite as a pi_bus_t probe
+ */
+static bool BusProbeWrite(void * Context, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    if (TestSpeedWrite(LAT, PWD, PGS, RLS)) {
+        return true;
+    }
+    *OutLanes = LastProbeLanes;
+    return false;
+}
+
+// Writable Domain 1 memory as seen by the search strategies (found by DetectWritableRegion)
+static const pi_bus_t Dom1WriteBus = { BusProbeWrite, NULL, NULL };
+
+/**
+ * @brief Put back what the write region held before the test
+ * @return false if the region does not read back as it was
+ */
+static bool RestoreWriteRegion(void) {
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    PiDmaWait(CartDom1WriteAsync(WriteOriginal, WRITE_REGION_START, WRITE_TEST_SIZE));
+    ReadBackWriteRegion();
+    return memcmp(UncachedAddr(WriteArena), UncachedAddr(WriteOriginal), WRITE_TEST_SIZE) == 0;
+}
+
+/**
+ * @brief Check that the write region is memory that is safe to write, at slowest speed
+ *
+ * Nothing is written until the read-only checks pass. The ROM must end inside
+ * the 8MB window, since a larger ROM (a repro or flash cart) may run on over
+ * the region and take writes as flash commands. The region is read twice and
+ * must not change on its own (a FIFO or a register would), must not be open
+ * bus and must not be a mirror of the ROM. Only then are both patterns
+ * written, and they must read back. The original contents are kept in
+ * WriteOriginal.
+ * @return false if the region is not writable memory (it is restored if it was written)
+ */
+bool DetectWritableRegion(void) {
+    // Patterns toggle every AD line between neighbouring halfwords and mix in the position
+    uint16_t * Halfwords = (uint16_t *)WritePatterns[0];
+    for (uint32_t i = 0; i < WRITE_TEST_SIZE / 2; i++) {
+        Halfwords[i] = (uint16_t)(((i & 1) ? 0xAAAA : 0x5555) ^ (i << 8) ^ (i >> 2));
+    }
+    for (uint32_t i = 0; i < WRITE_TEST_SIZE; i++) {
+        WritePatterns[1][i] = (uint8_t)~WritePatterns[0][i];
+    }
+    data_cache_hit_writeback(WritePatterns, sizeof(WritePatterns));
+    
+    if (CartRomSize >= CART_DOM1_SIZE) {
+        debugf("Write test: ROM fills the 8MB window and may cover 0x%08X, not written\n", WRITE_REGION_START);
+        return false;
+    }
+    
+    data_cache_hit_writeback_invalidate(WriteOriginal, sizeof(WriteOriginal));
+    data_cache_hit_writeback_invalidate(WriteArena, sizeof(WriteArena));
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    PiDmaWait(PiDmaRead(WriteOriginal, WRITE_REGION_START, WRITE_TEST_SIZE));
+    ReadBackWriteRegion();
+    
+    const uint8_t * Original = UncachedAddr(WriteOriginal);
+    if (memcmp(UncachedAddr(WriteArena), Original, WRITE_TEST_SIZE) != 0) {
+        return false;
+    }
+    bool OpenBus = true;
+    // Single reads of words 0 and 2, since a DMA burst repeats its start address
+    for (uint32_t Position = 0; Position < 16 && OpenBus; Position += 8) {
+        OpenBus = PiSweepWordIsOpenBus(WRITE_REGION_START + Position, io_read(WRITE_REGION_START + Position));
+    }
+    if (OpenBus) {
+        return false;
+    }
+    
+    // ROM repeated past its end reads back the same bytes at the offset modulo its size
+    CartDom1Read(WriteArena, (WRITE_REGION_START - CART_DOM1_START) % CartRomSize, WRITE_TEST_SIZE);
+    if (memcmp(UncachedAddr(WriteArena), Original, WRITE_TEST_SIZE) == 0) {
+        debugf("Write test: 0x%08X mirrors the ROM, not written\n", WRITE_REGION_START);
+        return false;
+    }
+    
+    bool Writable = TestSpeedWrite(0xFF, 0xFF, 0x07, 0x03) && TestSpeedWrite(0xFF, 0xFF, 0x07, 0x03);
+    bool Restored = RestoreWriteRegion();
+    if (!Restored) {
+        debugf("Write test: region at 0x%08X did not read back as before the test\n", WRITE_REGION_START);
+    }
+    return Writable && Restored;
+}
+
+/**
+ * @brief Start a write of BenchBuffer to the write region, for MeasureThroughput
+ */
+static uint32_t WriteRegionAsync(void * Buffer, uint32_t Offset, uint32_t Len) {
+    return CartDom1WriteAsync(Buffer, WRITE_REGION_START + Offset, Len);
+}
+
+// The write region as a throughput target, written from BenchBuffer
+static const bench_target_t Dom1WriteBench = { PI_DOMAIN_1, WriteRegionAsync, WRITE_TEST_SIZE, NULL };
+
+/**
+ * @brief Sweep the Domain 1 write frontier and measure write throughput
+ *
+ * Only runs on memory DetectWritableRegion accepts. Same frontier walk as the
+ * read sweep, drawn live in the matrix. The corner the timing model predicts
+ * fastest for a WRITE_TEST_SIZE write is measured next to the retail
+ * timing libdragon programs (PI_MODEL_RETAIL_*). The region is restored at
+ * the end.
+ */
+void RunWriteTest(void) {
+    memset(WriteMinPWDForLAT, 0xFF, sizeof(WriteMinPWDForLAT));
+    WriteBestLAT = 0xFF;
+    WriteBestPWD = 0xFF;
+    WriteKBPerSec = 0;
+    WriteDefaultKBPerSec = 0;
+    WriteTested = true;
+    
+    MatrixViewSetTable(WriteMinPWDForLAT, NULL);
+    MatrixViewClearText();
+    MatrixViewPrintf("Domain 1 writes...\n");
+    MatrixViewPresent(true);
+    
+    WritePresent = DetectWritableRegion();
+    if (!WritePresent) {
+        debugf("Write test: no writable memory at 0x%08X\n", WRITE_REGION_START);
+        return;
+    }
+    
+    PiSweepRun(&Dom1WriteBus, PI_SWEEP_FRONTIER, 0x07, 0x03, WriteMinPWDForLAT, NULL, NULL, SweepProgress, NULL);
+    
+    // Fastest frontier cell for one write according to the timing model
+    uint32_t BestCycles = 0;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        uint8_t PWD = WriteMinPWDForLAT[LAT];
+        if (PWD == 0xFF) {
+            continue;
+        }
+        uint32_t Cycles = PiModelCycles((uint8_t)LAT, PWD, 0x07, 0x03, WRITE_TEST_SIZE);
+        if (WriteBestLAT == 0xFF || Cycles < BestCycles) {
+            WriteBestLAT = (uint8_t)LAT;
+            WriteBestPWD = PWD;
+            BestCycles = Cycles;
+        }
+    }
+    
+    // The benchmark writes a pattern from BenchBuffer, so its lines must be in RDRAM
+    memcpy(BenchBuffer, WritePatterns[0], WRITE_TEST_SIZE);
+    data_cache_hit_writeback(BenchBuffer, WRITE_TEST_SIZE);
+    if (WriteBestLAT != 0xFF) {
+        WriteKBPerSec = MeasureThroughput(&Dom1WriteBench, WriteBestLAT, WriteBestPWD, 0x07, 0x03, WRITE_BENCH_REPEATS);
+    }
+    WriteDefaultKBPerSec = MeasureThroughput(&Dom1WriteBench, PI_MODEL_RETAIL_LAT, PI_MODEL_RETAIL_PWD,
+                                             PI_MODEL_RETAIL_PGS, PI_MODEL_RETAIL_RLS, WRITE_BENCH_REPEATS);
+    
+    bool Restored = RestoreWriteRegion();
+    debugf("Write test: LAT=0x%02X PWD=0x%02X PGS=0x7 RLS=0x3 %lu KB/s, retail timing %lu KB/s%s\n",
+           WriteBestLAT, WriteBestPWD, (unsigned long)WriteKBPerSec, (unsigned long)WriteDefaultKBPerSec,
+           Restored ? "" : ", region NOT restored");
+}
+#endif
+
+/**
+ * @brief Mark the LATs where PIO needs a higher PWD than DMA (or does not work at all)
+ */
+static void MarkPioStricter(void) {
+    PioStricterCount = 0;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        PioStricter[LAT] = (MinPWDForLAT[LAT] != 0xFF && PioMinPWDForLAT[LAT] > MinPWDForLAT[LAT]);
+        if (PioStricter[LAT]) {
+            PioStricterCount++;
+        }
+    }
+}
+
+/**
+ * @brief Find the minimum working PWD of the PIO read path for every LAT
+ *
+ * PIO is only checked on the DMA frontier: each LAT's DMA minimum is probed
+ * with TestSpeedPio and raised where it fails, with the same 16-LAT early exit
+ * as the sweep. Where PIO agrees with DMA this costs one probe per LAT instead
+ * of a second frontier walk.
+ */
+void RunPioSweep(void) {
+    PiSweepRaise(&Dom1PioBus, 0x07, 0x03, MinPWDForLAT, PioMinPWDForLAT, NULL, NULL);
+    
+    MarkPioStricter();
+    
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    debugf("PIO: %d LAT(s) need a higher PWD than DMA, %lu probes\n", PioStricterCount, (unsigned long)PioProbeCount);
+}
+
+#ifdef TRANSFER_PROFILES
+/**
+ * @brief Model cost of the fastest cell on a frontier, 0xFFFFFFFF if no LAT works
+ */
+static uint32_t FastestFrontierCycles(const uint8_t * PWDForLAT, uint8_t * OutLAT) {
+    uint32_t Best = 0xFFFFFFFF;
+    *OutLAT = 0xFF;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        if (PWDForLAT[LAT] == 0xFF) {
+            continue;
+        }
+        uint32_t Cycles = PiModelCycles((uint8_t)LAT, PWDForLAT[LAT], 0x07, 0x03, MODEL_WORKLOAD_SIZE);
+        if (Cycles < Best) {
+            Best = Cycles;
+            *OutLAT = (uint8_t)LAT;
+        }
+    }
+    return Best;
+}
+
+/**
+ * @brief Sweep a frontier for every profile in TRANSFER_PROFILES and combine them
+ *
+ * The samples frontier is already in MinPWDForLAT and stays there (the result
+ * cache confirms against it). Every other profile gets its own reference read
+ * at slowest speed and its own frontier walk. The strictest profile is the one
+ * whose fastest cell is slowest for a MODEL_WORKLOAD_SIZE transfer. The samples
+ * profile is selected again at the end.
+ * @param DmaPWDForLAT MinPWDForLAT, or SafePWDForLAT with MARGIN_TEST
+ * @return TransferPWDForLAT: the highest PWD any swept profile needs at each LAT
+ */
+const uint8_t * RunTransferProfiles(const uint8_t * DmaPWDForLAT) {
+    uint8_t FastestLAT;
+    uint32_t StrictestCycles = FastestFrontierCycles(MinPWDForLAT, &FastestLAT);
+    
+    memcpy(ProfileMinPWDForLAT[TRANSFER_SAMPLES], MinPWDForLAT, sizeof(MinPWDForLAT));
+    memcpy(TransferPWDForLAT, DmaPWDForLAT, sizeof(TransferPWDForLAT));
+    StrictestProfile = TRANSFER_SAMPLES;
+    
+    for (int Profile = TRANSFER_SAMPLES + 1; Profile < NUM_TRANSFER_PROFILES; Profile++) {
+        uint8_t * PWDs = ProfileMinPWDForLAT[Profile];
+        memset(PWDs, 0xFF, sizeof(ProfileMinPWDForLAT[Profile]));
+        if (!(TRANSFER_PROFILES & (1 << Profile))) {
+            continue;
+        }
+        
+        // Draw this profile's frontier as it is decided
+        MatrixViewSetTable(PWDs, NULL);
+        MatrixViewPresent(true);
+        SelectTransferProfile((transfer_profile_t)Profile);
+        PiSweepRun(&Dom1DmaBus, (pi_sweep_strategy_t)SWEEP_MODE, 0x07, 0x03, PWDs, NULL, NULL, SweepProgress, NULL);
+        
+        int Stricter = 0;
+        for (int LAT = 0; LAT < 256; LAT++) {
+            if (PWDs[LAT] > TransferPWDForLAT[LAT]) {
+                TransferPWDForLAT[LAT] = PWDs[LAT];
+            }
+            if (PWDs[LAT] > MinPWDForLAT[LAT]) {
+                Stricter++;
+            }
+        }
+        
+        uint32_t Cycles = FastestFrontierCycles(PWDs, &FastestLAT);
+        if (Cycles > StrictestCycles) {
+            StrictestCycles = Cycles;
+            StrictestProfile = Profile;
+        }
+        debugf("Transfer profile %s: fastest LAT=0x%02X PWD=0x%02X, %d LAT(s) stricter than the samples\n",
+               TransferProfileNames[Profile], FastestLAT, (FastestLAT != 0xFF) ? PWDs[FastestLAT] : 0xFF, Stricter);
+    }
+    
+    SelectTransferProfile(TRANSFER_SAMPLES);
+    MatrixViewSetTable(MinPWDForLAT, FrontierViolation);
+    
+    ProfileStricterCount = 0;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        ProfileStricter[LAT] = ProfileMinPWDForLAT[StrictestProfile][LAT] > MinPWDForLAT[LAT];
+        if (ProfileStricter[LAT]) {
+            ProfileStricterCount++;
+        }
+    }
+    debugf("Transfer profiles: %s is the strictest\n", TransferProfileNames[StrictestProfile]);
+    return TransferPWDForLAT;
+}
+#endif
+
+/**
+ * @brief Combine a DMA frontier with the PIO frontier into CandidatePWDForLAT
+ * @param DmaPWDForLAT MinPWDForLAT, SafePWDForLAT with MARGIN_TEST, or TransferPWDForLAT
+ *                     with TRANSFER_PROFILES
+ */
+void BuildCandidateTable(const uint8_t * DmaPWDForLAT) {
+    for (int LAT = 0; LAT < 256; LAT++) {
+        uint8_t DmaPWD = DmaPWDForLAT[LAT];
+        uint8_t PioPWD = PioMinPWDForLAT[LAT];
+        CandidatePWDForLAT[LAT] = (DmaPWD == 0xFF || PioPWD == 0xFF) ? 0xFF : (DmaPWD > PioPWD ? DmaPWD : PioPWD);
+    }
+}
+
+/**
+ * @brief Measure the time of one io_read at a combination
+ * @return Nanoseconds per 32-bit load
+ */
+uint32_t MeasurePioWordNs(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    SetDom1Speed(LAT, PWD, PGS, RLS);
+    
+    uint32_t Start = C0_COUNT();
+    for (uint32_t Position = 0; Position < PIO_LATENCY_WORDS * 4; Position += 4) {
+        (void)io_read(CART_DOM1_START + Position);
+    }
+    uint32_t Ticks = C0_COUNT() - Start;
+    
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    return (uint32_t)((uint64_t)Ticks * 1000000000ull / TICKS_PER_SECOND / PIO_LATENCY_WORDS);
+}
+
+/**
+ * @brief Measure throughput at every corner of a frontier
+ *
+ * Only LATs whose minimum PWD is lower than at every smaller LAT are measured:
+ * any other frontier cell has both a higher LAT and a PWD no lower than an
+ * earlier corner, so it cannot be faster.
+ * @param PWDForLAT Frontier to measure (normally CandidatePWDForLAT)
+ */
+void RunThroughputBenchmark(const uint8_t * PWDForLAT) {
+    NumFrontierPoints = 0;
+    uint8_t RunningMinPWD = 0xFF;
+    
+    for (int LAT = 0; LAT < 256; LAT++) {
+        uint8_t PWD = PWDForLAT[LAT];
+        if (PWD == 0xFF || (NumFrontierPoints > 0 && PWD >= RunningMinPWD)) {
+            continue;
+        }
+        RunningMinPWD = PWD;
+        
+        frontier_point_t * Point = &FrontierPoints[NumFrontierPoints++];
+        Point->LAT = (uint8_t)LAT;
+        Point->PWD = PWD;
+        Point->PGS = 0x07;
+        Point->RLS = 0x03;
+        Point->VerifyFailed = false;
+        Point->KBPerSec = MeasureThroughput(&Dom1Bench, (uint8_t)LAT, PWD, 0x07, 0x03, BENCH_REPEATS);
+        Point->PredictedKBPerSec = PiModelKBPerSec((uint8_t)LAT, PWD, 0x07, 0x03, BENCH_TRANSFER_SIZE);
+        debugf("Throughput: LAT=0x%02X PWD=0x%02X %lu KB/s (model %lu KB/s)\n",
+               LAT, PWD, (unsigned long)Point->KBPerSec, (unsigned long)Point->PredictedKBPerSec);
+    }
+    
+    // Set Domain 1 speed back to slowest after benchmarking
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+}
+
+#ifdef SWEEP_PGS_RLS
+/**
+ * @brief Search PGS and RLS together with the LAT/PWD frontier
+ *
+ * For every PGS/RLS pair, the minimum PWD is re-found at each LAT corner of the
+ * default (PGS=7, RLS=3) frontier, starting from the default answer, and each
+ * new corner is measured like the default frontier (BENCH_REPEATS DMAs) and
+ * appended to FrontierPoints. The probes add DMAs that straddle a page
+ * boundary, since the 128-byte sample blocks stay inside one page from PGS 5 up.
+ * Pruning:
+ * - Only LAT corners of the default frontier are searched
+ * - RLS goes from 3 down: once no corner works, smaller RLS values are skipped.
+ *   A smaller RLS only shortens the release between strobes, so it cannot
+ *   make a corner pass that failed with a longer release
+ * - Every PGS is searched: a page size is not known to fail in either direction
+ *   just because its neighbour did
+ */
+void RunTimingSearch(void) {
+    int NumCorners = NumFrontierPoints;
+    
+    SelectTransferProfile(TRANSFER_TIMING_SEARCH);
+    for (int PGS = 0; PGS < 16; PGS++) {
+        for (int RLS = 3; RLS >= 0; RLS--) {
+            if (PGS == 0x07 && RLS == 0x03) {
+                // Default timing, already measured by RunThroughputBenchmark
+                continue;
+            }
+            
+            bool AnyAtRLS = false;
+            uint8_t RunningMinPWD = 0xFF;
+            for (int i = 0; i < NumCorners && NumFrontierPoints < MAX_FRONTIER_POINTS; i++) {
+                const frontier_point_t * Corner = &FrontierPoints[i];
+                bool Violation;
+                uint16_t Lanes;
+                uint8_t PWD = PiSweepFindMinPWD(&Dom1DmaBus, Corner->LAT, Corner->PWD, (uint8_t)PGS, (uint8_t)RLS, &Violation, &Lanes);
+#ifdef MARGIN_TEST
+                PWD = FindSafePWD(Corner->LAT, PWD, (uint8_t)PGS, (uint8_t)RLS);
+#endif
+                if (PWD == 0xFF) {
+                    continue;
+                }
+                
+                // Same corner rule as RunThroughputBenchmark within this PGS/RLS pair
+                bool IsCorner = !AnyAtRLS || PWD < RunningMinPWD;
+                AnyAtRLS = true;
+                if (!IsCorner) {
+                    continue;
+                }
+                RunningMinPWD = PWD;
+                
+                frontier_point_t * Point = &FrontierPoints[NumFrontierPoints++];
+                Point->LAT = Corner->LAT;
+                Point->PWD = PWD;
+                Point->PGS = (uint8_t)PGS;
+                Point->RLS = (uint8_t)RLS;
+                Point->VerifyFailed = false;
+                Point->KBPerSec = MeasureThroughput(&Dom1Bench, Point->LAT, PWD, (uint8_t)PGS, (uint8_t)RLS, BENCH_REPEATS);
+                Point->PredictedKBPerSec = PiModelKBPerSec(Point->LAT, PWD, (uint8_t)PGS, (uint8_t)RLS, BENCH_TRANSFER_SIZE);
+                debugf("Throughput: LAT=0x%02X PWD=0x%02X PGS=0x%X RLS=0x%X %lu KB/s (model %lu KB/s)\n",
+                       Point->LAT, PWD, PGS, RLS, (unsigned long)Point->KBPerSec,
+                       (unsigned long)Point->PredictedKBPerSec);
+            }
+            
+            if (!AnyAtRLS) {
+                break;
+            }
+        }
+    }
+    
+    // Back to the sample blocks for the PIO probes and verification
+    SelectTransferProfile(TRANSFER_SAMPLES);
+}
+#endif
+
+/**
+ * @brief Print how far the timing model is from the measured throughput
+ */
+void RenderModelCheck(void) {
+    uint32_t TotalError = 0;
+    uint32_t MaxError = 0;
+    int Count = 0;
+    
+    for (int i = 0; i < NumFrontierPoints; i++) {
+        const frontier_point_t * Point = &FrontierPoints[i];
+        if (Point->KBPerSec == 0) {
+            continue;
+        }
+        uint32_t Diff = (Point->PredictedKBPerSec > Point->KBPerSec) ?
+                        (Point->PredictedKBPerSec - Point->KBPerSec) : (Point->KBPerSec - Point->PredictedKBPerSec);
+        uint32_t Error = Diff * 100 / Point->KBPerSec;
+        TotalError += Error;
+        if (Error > MaxError) {
+            MaxError = Error;
+        }
+        Count++;
+    }
+    
+    if (Count > 0) {
+        MatrixViewPrintf("Model error: avg %lu%%, max %lu%%\n",
+                         (unsigned long)(TotalError / Count), (unsigned long)MaxError);
+    }
+}
+
+/**
+ * @brief Print the measured throughput table (3 frontier points per line)
+ */
+void RenderThroughputTable(void) {
+    MatrixViewPrintf("Throughput (LAT/PWD MB/s):\n");
+    
+    // The default PGS/RLS corners come first; PGS/RLS search points are only logged
+    int NumDefault = 0;
+    while (NumDefault < NumFrontierPoints &&
+           FrontierPoints[NumDefault].PGS == 0x07 && FrontierPoints[NumDefault].RLS == 0x03) {
+        NumDefault++;
+    }
+    
+    int Shown = (NumDefault < BENCH_TABLE_ENTRIES) ? NumDefault : BENCH_TABLE_ENTRIES;
+    for (int i = 0; i < Shown; i++) {
+        const frontier_point_t * Point = &FrontierPoints[i];
+        MatrixViewPrintf("%02X/%02X %2lu.%02lu", Point->LAT, Point->PWD,
+                         (unsigned long)(Point->KBPerSec / 1000), (unsigned long)((Point->KBPerSec % 1000) / 10));
+        MatrixViewPrintf(((i % 3) == 2 || i == Shown - 1) ? "\n" : "  ");
+    }
+}
+
+#ifdef RSP_VERIFY
+/**
+ * @brief Fold the signature of the previous chunk's hash job into the rolling hash
+ */
+static void VerifyStreamCollect(verify_stream_t * Stream) {
+    if (!Stream->Pending) {
+        return;
+    }
+    
+    uint8_t Signature[RSP_VERIFY_SIGNATURE_SIZE];
+    if (Stream->PendingJob >= 0 && RspVerifyWait(Stream->PendingJob)) {
+        RspVerifySignature(Stream->PendingJob, Signature);
+    } else {
+        RspVerifySignatureCpu(Stream->PendingData, Stream->PendingLen, Signature);
+    }
+    Stream->Hash = RomHashUpdate(Stream->Hash, Signature, sizeof(Signature));
+    Stream->Pending = false;
+}
+#endif
+
+/**
+ * @brief Stream callback: fold a chunk into the verification checksum and hash
+ *
+ * With the RSP hashing, only a 32-byte signature of each chunk goes into the
+ * rolling hash: a 16-bit Fletcher checksum per halfword lane. That is weaker
+ * than hashing every byte as the CPU path does, so two different reads are
+ * more likely to give the same hash. The header CRC check is not affected.
+ */
+static void VerifyStreamCallback(const uint8_t * Data, uint32_t Offset, uint32_t Len, void * Context) {
+    verify_stream_t * Stream = (verify_stream_t *)Context;
+    
+#ifdef RSP_VERIFY
+    if (HashOnRsp) {
+        // The RSP reduces this chunk to a signature while the CPU does the checksum and
+        // the PI reads on; it is collected in the next callback, before the chunk is refilled
+        int32_t Job = RspVerifyPostHash(Data, Len);
+        if (Stream->WithChecksum) {
+            RomChecksumUpdate(&Stream->Checksum, Data, Len);
+        }
+        VerifyStreamCollect(Stream);
+        Stream->Pending = true;
+        Stream->PendingJob = Job;
+        Stream->PendingData = Data;
+        Stream->PendingLen = Len;
+        return;
+    }
+#endif
+    
+    if (Stream->WithChecksum) {
+        RomChecksumUpdate(&Stream->Checksum, Data, Len);
+    }
+    Stream->Hash = RomHashUpdate(Stream->Hash, Data, Len);
+}
+
+/**
+ * @brief Stream a region at the current speed into a checksum and/or rolling hash
+ */
+static void StreamVerifyRegion(uint32_t Offset, uint32_t Len, bool WithChecksum, verify_stream_t * Stream) {
+    Stream->WithChecksum = WithChecksum;
+    Stream->Hash = ROM_HASH_SEED;
+    if (WithChecksum) {
+        RomChecksumInit(&Stream->Checksum, CartCic, BootRegion);
+    }
+#ifdef RSP_VERIFY
+    Stream->Pending = false;
+#endif
+    CartDom1Stream(Offset, Len, VerifyStreamCallback, Stream);
+#ifdef RSP_VERIFY
+    VerifyStreamCollect(Stream);
+#endif
+}
+
+/**
+ * @brief Check the streamed checksum against the header CRC1/CRC2
+ */
+static bool HeaderCrcMatches(const verify_stream_t * Stream) {
+    uint32_t Crc1, Crc2;
+    RomChecksumFinal(&Stream->Checksum, &Crc1, &Crc2);
+    return Crc1 == RomReadWord(BootRegion + ROM_CRC1_OFFSET) &&
+           Crc2 == RomReadWord(BootRegion + ROM_CRC2_OFFSET);
+}
+
+/**
+ * @brief Read the header and boot code at slowest speed and reset verification state
+ */
+void VerifyInit(void) {
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    data_cache_hit_writeback_invalidate(BootRegion, sizeof(BootRegion));
+    CartDom1Read(BootRegion, 0, sizeof(BootRegion));
+    data_cache_hit_invalidate(BootRegion, sizeof(BootRegion));
+    
+    CartCic = RomDetectCic(BootRegion);
+    HeaderCrcValid = (CartCic != CIC_UNKNOWN);
+    RegionHashValid = false;
+    FullRomHashValid = false;
+#ifdef RSP_VERIFY
+    // Fixed per cart, so reference and candidate hashes are always comparable
+    HashOnRsp = RspVerifyAvailable();
+#endif
+}
+
+/**
+ * @brief Verify a LAT/PWD/PGS/RLS combination on the whole checksummed region
+ *
+ * Streams the 1MB covered by the header CRC1/CRC2 at the candidate speed and
+ * recomputes the checksum. If the header CRCs cannot be used (unknown CIC, or
+ * they do not match even at the slowest speed) the region's rolling hash is
+ * compared against a slow-speed pass instead. With VERIFY_FULL_ROM, all of
+ * Domain 1 is also hashed and compared against a slow-speed pass.
+ * @return true if the data read at this speed is intact
+ */
+bool VerifySpeed(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    verify_stream_t Stream;
+    
+    SetDom1Speed(LAT, PWD, PGS, RLS);
+    StreamVerifyRegion(ROM_CHECKSUM_START, ROM_CHECKSUM_LENGTH, HeaderCrcValid, &Stream);
+    
+    bool Intact;
+    if (HeaderCrcValid && HeaderCrcMatches(&Stream)) {
+        Intact = true;
+    } else {
+        if (!RegionHashValid) {
+            // Reference pass at slowest speed; also tells whether the header CRCs are usable
+            verify_stream_t Reference;
+            SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+            StreamVerifyRegion(ROM_CHECKSUM_START, ROM_CHECKSUM_LENGTH, HeaderCrcValid, &Reference);
+            if (HeaderCrcValid && !HeaderCrcMatches(&Reference)) {
+                debugf("Verify: header CRCs do not match at slowest speed, using hash\n");
+                HeaderCrcValid = false;
+            }
+            RegionHashRef = Reference.Hash;
+            RegionHashValid = true;
+        }
+        Intact = (Stream.Hash == RegionHashRef);
+    }
+    
+#ifdef VERIFY_FULL_ROM
+    if (Intact) {
+        if (!FullRomHashValid) {
+            SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+            StreamVerifyRegion(0, CART_DOM1_SIZE, false, &Stream);
+            FullRomHashRef = Stream.Hash;
+            FullRomHashValid = true;
+        }
+        SetDom1Speed(LAT, PWD, PGS, RLS);
+        StreamVerifyRegion(0, CART_DOM1_SIZE, false, &Stream);
+        Intact = (Stream.Hash == FullRomHashRef);
+    }
+#endif
+    
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    return Intact;
+}
+
+#ifdef CONTENTION_BENCH
+/**
+ * @brief TestSpeed as a pi_bus_t probe, topping up the RDRAM load first
+ *
+ * The RDP load drains within a few milliseconds, so it is pumped before every
+ * probe rather than once per LAT. Nothing is drawn: presents would add RDRAM
+ * traffic of their own.
+ */
+static bool BusProbeLoaded(void * Context, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    BusLoadPump();
+    return BusProbeDma(Context, LAT, PWD, PGS, RLS, OutLanes);
+}
+
+static const pi_bus_t Dom1LoadedBus = { BusProbeLoaded, BusReadDom1Words, NULL };
+
+// Domain 1 throughput with the load topped up between DMAs
+static const bench_target_t Dom1LoadedBench = { PI_DOMAIN_1, CartDom1ReadAsync, BENCH_TRANSFER_SIZE, BusLoadPump };
+
+/**
+ * @brief Sweep the frontier and benchmark the chosen timing again under every RDRAM load
+ *
+ * The main sweep runs with the 32bpp display scanning out. Here every load
+ * in bus_load_t gets its own frontier, throughput of the chosen timing and
+ * CONTENTION_PROBES probes of it. Frontiers are compared with the display-off
+ * one, the idle bus. The display is switched for each load, so the matrix is
+ * taken down and started again afterwards. None of the probes count as sweep
+ * probes or touch the latency cells.
+ */
+void RunContentionBench(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    MatrixViewEnd();
+    ProbesUncounted = true;
+    
+    for (int Load = 0; Load < NUM_BUS_LOADS; Load++) {
+        load_result_t * Result = &LoadResults[Load];
+        memset(Result, 0, sizeof(*Result));
+        memset(Result->MinPWDForLAT, 0xFF, sizeof(Result->MinPWDForLAT));
+#ifdef RSP_VERIFY
+        // rdpq needs the RSP, so probes under this load compare on the CPU
+        RspVerifySetEnabled(Load != BUS_LOAD_RDP);
+#endif
+        
+        BusLoadBegin((bus_load_t)Load);
+        PiSweepRun(&Dom1LoadedBus, (pi_sweep_strategy_t)SWEEP_MODE, 0x07, 0x03, Result->MinPWDForLAT,
+                   NULL, NULL, NULL, NULL);
+        Result->Passes = true;
+        for (int i = 0; i < CONTENTION_PROBES && Result->Passes; i++) {
+            uint16_t Lanes;
+            Result->Passes = BusProbeLoaded(NULL, LAT, PWD, PGS, RLS, &Lanes);
+        }
+        Result->KBPerSec = MeasureThroughput(&Dom1LoadedBench, LAT, PWD, PGS, RLS, BENCH_REPEATS);
+        SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+        BusLoadEnd();
+        Result->Measured = true;
+    }
+#ifdef RSP_VERIFY
+    RspVerifySetEnabled(true);
+#endif
+    ProbesUncounted = false;
+    
+    // Compare every frontier with the idle bus
+    const uint8_t * IdlePWDs = LoadResults[BUS_LOAD_DISPLAY_OFF].MinPWDForLAT;
+    WorstLoad = BUS_LOAD_DISPLAY_OFF;
+    for (int Load = 0; Load < NUM_BUS_LOADS; Load++) {
+        load_result_t * Result = &LoadResults[Load];
+        if (!Result->Measured) {
+            continue;
+        }
+        for (int i = 0; i < 256; i++) {
+            if (Result->MinPWDForLAT[i] > IdlePWDs[i]) {
+                Result->Stricter++;
+            }
+        }
+        // On a tie the earlier, lighter load stays the worst: the heavier one adds nothing stricter
+        if (Result->Stricter > LoadResults[WorstLoad].Stricter) {
+            WorstLoad = Load;
+        }
+        debugf("Contention: %s load, LAT=0x%02X PWD=0x%02X PGS=0x%X RLS=0x%X %lu KB/s, %s, %d LAT(s) stricter than display off\n",
+               BusLoadName((bus_load_t)Load), LAT, PWD, PGS, RLS, (unsigned long)Result->KBPerSec,
+               Result->Passes ? "passes" : "FAILS", Result->Stricter);
+    }
+    for (int i = 0; i < 256; i++) {
+        LoadStricter[i] = LoadResults[WorstLoad].MinPWDForLAT[i] > IdlePWDs[i];
+    }
+    
+    MatrixViewBegin(CartridgeName, MinPWDForLAT, FrontierViolation);
+}
+#endif
+
+/**
+ * @brief Time PROBE_RATE_PROBES probes of a timing
+ * @return Probes per second
+ */
+static uint32_t TimeProbes(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    uint32_t Start = C0_COUNT();
+    for (int i = 0; i < PROBE_RATE_PROBES; i++) {
+        TestSpeed(LAT, PWD, PGS, RLS);
+    }
+    uint32_t Ticks = C0_COUNT() - Start;
+    return (Ticks > 0) ? (uint32_t)((uint64_t)PROBE_RATE_PROBES * TICKS_PER_SECOND / Ticks) : 0;
+}
+
+/**
+ * @brief Measure the probe rate at the chosen timing with CPU compares and, with RSP_VERIFY, RSP compares
+ *
+ * The probes are not counted as sweep probes and leave the latency cells alone.
+ */
+void MeasureProbeRates(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    ProbesUncounted = true;
+#ifdef RSP_VERIFY
+    RspProbesPerSec = RspVerifyAvailable() ? TimeProbes(LAT, PWD, PGS, RLS) : 0;
+    RspVerifySetEnabled(false);
+#endif
+    CpuProbesPerSec = TimeProbes(LAT, PWD, PGS, RLS);
+#ifdef RSP_VERIFY
+    RspVerifySetEnabled(true);
+#endif
+    ProbesUncounted = false;
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    
+    debugf("Probe rate at LAT=0x%02X PWD=0x%02X: %lu/s with CPU compares, %lu/s with RSP compares\n",
+           LAT, PWD, (unsigned long)CpuProbesPerSec, (unsigned long)RspProbesPerSec);
+}
+
+/**
+ * @brief Run speed test - find minimum working PWD for each LAT (0-255), displayed as 16x16 grid
+ * @param OutLAT Output parameter for fastest working LAT value (best overall)
+ * @param OutPWD Output parameter for fastest working PWD value (best overall)
+ * @param OutPGS Output parameter for the page size of the best combination
+ * @param OutRLS Output parameter for the release time of the best combination
+ * @return Speed level corresponding to the fastest working combination
+ */
+speed_level_t RunSpeedTest(uint8_t * OutLAT, uint8_t * OutPWD, uint8_t * OutPGS, uint8_t * OutRLS) {
+    // Initialize matrix - all 256 LAT values
+    for (int LAT = 0; LAT < 256; LAT++) {
+        MinPWDForLAT[LAT] = 0xFF;  // 0xFF means no working PWD found
+        FrontierViolation[LAT] = false;
+        FirstFailLanes[LAT] = 0;
+    }
+    FrontierViolationCount = 0;
+    ProbeCount = 0;
+    PioProbeCount = 0;
+    ProbeTicks = 0;
+    CpuProbesPerSec = 0;
+    RspProbesPerSec = 0;
+    uint64_t SweepStart = get_ticks();
+    PiDmaResetStats();
+#ifdef PROFILE_PHASES
+    ProfileReset();
+#endif
+    
+    // Show the empty matrix; from here on only changed cells are redrawn
+    MatrixViewBegin(CartridgeName, MinPWDForLAT, FrontierViolation);
+    MatrixViewPrintf("Selecting sample blocks...\n");
+    MatrixViewPresent(true);
+    
+    // Pick the hardest sample blocks, then read their reference data at slowest speed
+    SelectSampleBlocks();
+    ReadReferenceData();
+#ifdef DMA_LATENCY
+    CalibrateDmaLatency();
+#endif
+    
+    MatrixViewPrintf("Testing speeds...\n");
+    
+    // Find the minimum working PWD of all 256 LAT values, drawing each as it is decided
+    FrontierViolationCount = PiSweepRun(&Dom1DmaBus, (pi_sweep_strategy_t)SWEEP_MODE, 0x07, 0x03, MinPWDForLAT,
+                                        FrontierViolation, FirstFailLanes, SweepProgress, NULL);
+    MatrixViewPresent(false);
+    for (int LAT = 1; LAT < 256; LAT++) {
+        if (FrontierViolation[LAT]) {
+            debugf("Frontier: LAT=0x%02X needs PWD=0x%02X, above previous LAT's 0x%02X\n",
+                   LAT, MinPWDForLAT[LAT], MinPWDForLAT[LAT - 1]);
+        }
+    }
+    
+#ifdef MARGIN_TEST
+    // Replace single-pass minimums with repeated-probe decisions before choosing candidates
+    MatrixViewPrintf("Margin testing...\n");
+    MatrixViewPresent(true);
+    RunMarginTest();
+    const uint8_t * DmaPWDs = SafePWDForLAT;
+#else
+    const uint8_t * DmaPWDs = MinPWDForLAT;
+#endif
+#ifdef TRANSFER_PROFILES
+    // Every transfer shape has to pass at a candidate's timing
+    MatrixViewPrintf("Testing transfer profiles...\n");
+    MatrixViewPresent(true);
+    DmaPWDs = RunTransferProfiles(DmaPWDs);
+#endif
+    
+    // CPU loads can fail where DMA passes, so candidates must satisfy both frontiers
+    MatrixViewPrintf("Testing PIO reads...\n");
+    MatrixViewPresent(true);
+    RunPioSweep();
+    BuildCandidateTable(DmaPWDs);
+    
+    // Measure sustained throughput along the frontier
+    MatrixViewPrintf("Measuring throughput...\n");
+    MatrixViewPresent(true);
+    RunThroughputBenchmark(CandidatePWDForLAT);
+#ifdef SWEEP_PGS_RLS
+    MatrixViewPrintf("Searching PGS/RLS...\n");
+    MatrixViewPresent(true);
+    RunTimingSearch();
+#endif
+    
+    // Verify candidates on the whole checksummed region, stepping back along the frontier
+    // until one is intact
+    MatrixViewPrintf("Verifying...\n");
+    MatrixViewPresent(true);
+    VerifyInit();
+    VerifyStepBacks = 0;
+    
+    uint8_t BestLAT = 0xFF;
+    uint8_t BestPWD = 0xFF;
+    uint8_t BestPGS = 0x07;
+    uint8_t BestRLS = 0x03;
+    uint32_t BestKBPerSec = 0;
+    while (BestLAT == 0xFF) {
+        // The best candidate is the frontier point with the lowest predicted time
+        // for a MODEL_WORKLOAD_SIZE transfer
+        frontier_point_t * Candidate = NULL;
+        uint64_t BestCost = 0;
+        for (int i = 0; i < NumFrontierPoints; i++) {
+            frontier_point_t * Point = &FrontierPoints[i];
+            if (Point->VerifyFailed) {
+                continue;
+            }
+            uint64_t Cost = PredictWorkloadCost(Point);
+            if (Candidate == NULL || Cost < BestCost) {
+                Candidate = Point;
+                BestCost = Cost;
+            }
+        }
+        
+        if (Candidate == NULL) {
+            // Every frontier point failed verification
+            break;
+        }
+        
+        if (!TestSpeedPio(Candidate->LAT, Candidate->PWD, Candidate->PGS, Candidate->RLS)) {
+            // PGS/RLS search points are only swept with DMA
+            Candidate->VerifyFailed = true;
+            VerifyStepBacks++;
+            debugf("Verify: LAT=0x%02X PWD=0x%02X PGS=0x%X RLS=0x%X PIO reads corrupted, stepping back\n",
+                   Candidate->LAT, Candidate->PWD, Candidate->PGS, Candidate->RLS);
+        } else if (VerifySpeed(Candidate->LAT, Candidate->PWD, Candidate->PGS, Candidate->RLS)) {
+            BestLAT = Candidate->LAT;
+            BestPWD = Candidate->PWD;
+            BestPGS = Candidate->PGS;
+            BestRLS = Candidate->RLS;
+            BestKBPerSec = Candidate->KBPerSec;
+        } else {
+            Candidate->VerifyFailed = true;
+            VerifyStepBacks++;
+            debugf("Verify: LAT=0x%02X PWD=0x%02X PGS=0x%X RLS=0x%X corrupted data, stepping back\n",
+                   Candidate->LAT, Candidate->PWD, Candidate->PGS, Candidate->RLS);
+        }
+    }
+    BestKBPerSecMeasured = BestKBPerSec;
+#ifdef DMA_LATENCY
+    SummarizeDmaLatency();
+#endif
+    
+    // Per-access cost of both read paths at the chosen timing
+    DmaWordNs = (BestKBPerSec > 0) ? 4000000 / BestKBPerSec : 0;
+    PioWordNs = (BestLAT != 0xFF) ? MeasurePioWordNs(BestLAT, BestPWD, BestPGS, BestRLS) : 0;
+#ifdef CONTENTION_BENCH
+    // STATE_CONTENTION runs the bench once the result is up
+    WorstLoad = -1;
+#endif
+    PiDmaGetStats(&SweepDmaStats);
+    SweepTicks = get_ticks() - SweepStart;
+    if (BestLAT != 0xFF) {
+        MeasureProbeRates(BestLAT, BestPWD, BestPGS, BestRLS);
+    }
+    
+    // Map the best working LAT/PWD to a speed level
+    if (BestLAT != 0xFF && BestPWD != 0xFF) {
+        if (OutLAT != NULL) {
+            *OutLAT = BestLAT;
+        }
+        if (OutPWD != NULL) {
+            *OutPWD = BestPWD;
+        }
+        if (OutPGS != NULL) {
+            *OutPGS = BestPGS;
+        }
+        if (OutRLS != NULL) {
+            *OutRLS = BestRLS;
+        }
+        return MapSpeedToLevel(BestLAT, BestPWD, BestPGS, BestRLS);
+    } else {
+        // No working speed found (shouldn't happen, but handle it)
+        if (OutLAT != NULL) {
+            *OutLAT = 0xFF;
+        }
+        if (OutPWD != NULL) {
+            *OutPWD = 0xFF;
+        }
+        if (OutPGS != NULL) {
+            *OutPGS = 0x07;
+        }
+        if (OutRLS != NULL) {
+            *OutRLS = 0x03;
+        }
+        return SPEED_LEVEL_TOTAL_POS;
+    }
+}
+
+/**
+ * @brief Format a per-LAT PWD table as 512 hex digits
+ * @param Out Buffer of at least 513 bytes
+ */
+static void FormatPWDTable(const uint8_t * Table, char * Out) {
+    static const char HexDigits[] = "0123456789ABCDEF";
+    for (int i = 0; i < 256; i++) {
+        Out[i * 2] = HexDigits[Table[i] >> 4];
+        Out[i * 2 + 1] = HexDigits[Table[i] & 0x0F];
+    }
+    Out[256 * 2] = '\0';
+}
+
+/**
+ * @brief Predict how long the IPL3 load of the checksummed 1MB takes with a header timing word
+ */
+static uint32_t PredictBootMicroseconds(uint32_t Word) {
+    uint8_t LAT, PWD, PGS, RLS;
+    RomParseTimingWord(Word, &LAT, &PWD, &PGS, &RLS);
+    uint32_t Cycles = PiModelCycles(LAT, PWD, PGS, RLS, ROM_CHECKSUM_LENGTH);
+    return (uint32_t)((uint64_t)Cycles * 1000000 / PI_MODEL_RCP_HZ);
+}
+
+/**
+ * @brief Encode a timing into the cart's header word and build its IPS patch
+ * @return true if the patched word boots faster than the stock one
+ */
+static bool BuildHeaderPatch(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, header_patch_t * Out) {
+    static const char HexDigits[] = "0123456789ABCDEF";
+    uint8_t Ips[ROM_IPS_WORD_PATCH_SIZE];
+    
+    Out->StockWord = StockHeaderWord;
+    Out->PatchedWord = RomMakeTimingWord(StockHeaderWord, LAT, PWD, PGS, RLS);
+    Out->StockBootUs = PredictBootMicroseconds(Out->StockWord);
+    Out->PatchedBootUs = PredictBootMicroseconds(Out->PatchedWord);
+    
+    RomMakeIpsWordPatch(ROM_TIMING_OFFSET, Out->PatchedWord, Ips);
+    for (int i = 0; i < ROM_IPS_WORD_PATCH_SIZE; i++) {
+        Out->IpsHex[i * 2] = HexDigits[Ips[i] >> 4];
+        Out->IpsHex[i * 2 + 1] = HexDigits[Ips[i] & 0x0F];
+    }
+    Out->IpsHex[ROM_IPS_WORD_PATCH_SIZE * 2] = '\0';
+    
+    return Out->PatchedBootUs < Out->StockBootUs;
+}
+
+/**
+ * @brief Send the result of the last sweep (or cache confirmation) as a CART record over ISViewer
+ * @param LAT Chosen latency
+ * @param PWD Chosen pulse width
+ * @param PGS Chosen page size
+ * @param RLS Chosen release time
+ * @param Level Speed level of the chosen combination
+ * @param Cached Cache entry the result was confirmed from, NULL after a full sweep
+ */
+void ExportCartResult(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, speed_level_t Level,
+                      const result_cache_entry_t * Cached) {
+    // Name as printable ASCII without trailing padding
+    char Name[sizeof(CartridgeName)];
+    int NameLen = 0;
+    for (int i = 0; CartridgeName[i] != '\0'; i++) {
+        char c = CartridgeName[i];
+        Name[i] = (c >= 0x20 && c < 0x7F) ? c : '?';
+        if (c != ' ') {
+            NameLen = i + 1;
+        }
+    }
+    Name[NameLen] = '\0';
+    
+    // Minimum PWD for every LAT as 512 hex digits, FF where none worked
+    char PWDTable[256 * 2 + 1];
+    FormatPWDTable(MinPWDForLAT, PWDTable);
+    
+    const pidma_stats_t DmaStats = SweepDmaStats;
+    
+    ExportBegin("CART");
+    ExportLine("NAME %s", Name);
+    ExportLine("HDR crc1=%08lX crc2=%08lX cic=%s crcok=%d",
+               (unsigned long)RomReadWord(BootRegion + ROM_CRC1_OFFSET),
+               (unsigned long)RomReadWord(BootRegion + ROM_CRC2_OFFSET),
+               RomCicName(CartCic), HeaderCrcValid ? 1 : 0);
+    ExportLine("BEST lat=%02X pwd=%02X pgs=%X rls=%X kbps=%lu model=%lu level=%d",
+               LAT, PWD, PGS, RLS, (unsigned long)BestKBPerSecMeasured,
+               (unsigned long)PiModelPercentOfRetail(LAT, PWD, PGS, RLS, MODEL_WORKLOAD_SIZE), (int)Level);
+    header_patch_t Patch;
+    if (LAT != 0xFF && BuildHeaderPatch(LAT, PWD, PGS, RLS, &Patch)) {
+        ExportLine("HDRPATCH stock=%08lX patched=%08lX boot_us=%lu patched_boot_us=%lu",
+                   (unsigned long)Patch.StockWord, (unsigned long)Patch.PatchedWord,
+                   (unsigned long)Patch.StockBootUs, (unsigned long)Patch.PatchedBootUs);
+        ExportLine("IPS %s", Patch.IpsHex);
+    }
+    ExportLine("STAT probes=%lu sweep_ms=%lu pi_ms=%lu wait_ms=%lu violations=%d stepbacks=%d",
+               (unsigned long)ProbeCount,
+               (unsigned long)(SweepTicks / (TICKS_PER_SECOND / 1000)),
+               (unsigned long)(DmaStats.BusyTicks / (TICKS_PER_SECOND / 1000)),
+               (unsigned long)(DmaStats.WaitTicks / (TICKS_PER_SECOND / 1000)),
+               FrontierViolationCount, VerifyStepBacks);
+    if (Cached != NULL) {
+        // STAT then covers the confirmation probes instead of a sweep
+        ExportLine("CACHE age_s=%lu", (unsigned long)((get_ticks() - Cached->StoredTicks) / TICKS_PER_SECOND));
+    }
+    ExportLine("MIN %s", PWDTable);
+    FormatPWDTable(PioMinPWDForLAT, PWDTable);
+    ExportLine("PIOMIN %s", PWDTable);
+    ExportLine("PIO dma_ns=%lu pio_ns=%lu stricter=%d probes=%lu",
+               (unsigned long)DmaWordNs, (unsigned long)PioWordNs, PioStricterCount, (unsigned long)PioProbeCount);
+    
+    // Failing AD lines below the minimum PWD of every LAT as 1024 hex digits
+    char LaneTable[256 * 4 + 1];
+    for (int i = 0; i < 256; i++) {
+        snprintf(LaneTable + i * 4, 5, "%04X", FirstFailLanes[i]);
+    }
+    ExportLine("LANES %s", LaneTable);
+    ExportLine("DOM2 present=%d lat=%02X pwd=%02X kbps=%lu default_kbps=%lu pattern=%d identified=%d",
+               Dom2Present ? 1 : 0, Dom2BestLAT, Dom2BestPWD,
+               (unsigned long)Dom2KBPerSec, (unsigned long)Dom2DefaultKBPerSec, Dom2Pattern ? 1 : 0,
+               Dom2Identified ? 1 : 0);
+    if (Dom2Present && Dom2Pattern) {
+        FormatPWDTable(Dom2MinPWDForLAT, PWDTable);
+        ExportLine("DOM2MIN %s", PWDTable);
+    }
+#ifdef MARGIN_TEST
+    if (MarginalLATCount >= 0) {
+        ExportLine("MARGIN marginal=%d probes=%lu capped=%d", MarginalLATCount,
+                   (unsigned long)MarginProbes, MarginBudgetHit ? 1 : 0);
+        FormatPWDTable(SafePWDForLAT, PWDTable);
+        ExportLine("SAFE %s", PWDTable);
+    }
+#endif
+#ifdef WRITE_TEST
+    if (WriteTested) {
+        ExportLine("WRITE present=%d lat=%02X pwd=%02X kbps=%lu default_kbps=%lu",
+                   WritePresent ? 1 : 0, WriteBestLAT, WriteBestPWD,
+                   (unsigned long)WriteKBPerSec, (unsigned long)WriteDefaultKBPerSec);
+        if (WritePresent) {
+            FormatPWDTable(WriteMinPWDForLAT, PWDTable);
+            ExportLine("WRITEMIN %s", PWDTable);
+        }
+    }
+#endif
+#ifdef TRANSFER_PROFILES
+    // Frontier of every swept transfer profile besides the samples (the MIN line)
+    if (StrictestProfile >= 0) {
+        ExportLine("XFER strictest=%s stricter=%d", TransferProfileNames[StrictestProfile], ProfileStricterCount);
+        for (int Profile = TRANSFER_SAMPLES + 1; Profile < NUM_TRANSFER_PROFILES; Profile++) {
+            if (TRANSFER_PROFILES & (1 << Profile)) {
+                FormatPWDTable(ProfileMinPWDForLAT[Profile], PWDTable);
+                ExportLine("XFERMIN %s %s", TransferProfileNames[Profile], PWDTable);
+            }
+        }
+    }
+#endif
+#ifdef CONTENTION_BENCH
+    // The chosen timing and the frontier under every RDRAM load that was run
+    if (WorstLoad >= 0) {
+        ExportLine("CONTENTION worst=%s stricter=%d", BusLoadName((bus_load_t)WorstLoad),
+                   LoadResults[WorstLoad].Stricter);
+        for (int Load = 0; Load < NUM_BUS_LOADS; Load++) {
+            const load_result_t * Result = &LoadResults[Load];
+            if (Result->Measured) {
+                ExportLine("LOAD %s kbps=%lu pass=%d stricter=%d", BusLoadName((bus_load_t)Load),
+                           (unsigned long)Result->KBPerSec, Result->Passes ? 1 : 0, Result->Stricter);
+                FormatPWDTable(Result->MinPWDForLAT, PWDTable);
+                ExportLine("LOADMIN %s %s", BusLoadName((bus_load_t)Load), PWDTable);
+            }
+        }
+    }
+#endif
+#ifdef DMA_LATENCY
+    // Measured bus time per halfword at each LAT's minimum PWD as 1024 hex digits, FFFF where not timed
+    ExportLine("LATENCY verdict=%d offset16=%ld slope=%ld overhead=%lu mismatched=%d cells=%d",
+               (int)LatencySummary.Verdict, (long)LatencySummary.Offset16, (long)LatencySummary.SlopePercent,
+               (unsigned long)PiLatencyOverheadCycles(), LatencySummary.Mismatched, LatencySummary.Cells);
+    for (int i = 0; i < 256; i++) {
+        snprintf(LaneTable + i * 4, 5, "%04X", LatencyNs[i]);
+    }
+    ExportLine("LATNS %s", LaneTable);
+#endif
+    for (int i = 0; i < NumFrontierPoints; i++) {
+        const frontier_point_t * Point = &FrontierPoints[i];
+        ExportLine("PT lat=%02X pwd=%02X pgs=%X rls=%X kbps=%lu pred=%lu fail=%d",
+                   Point->LAT, Point->PWD, Point->PGS, Point->RLS,
+                   (unsigned long)Point->KBPerSec, (unsigned long)Point->PredictedKBPerSec,
+                   Point->VerifyFailed ? 1 : 0);
+    }
+    ExportEnd();
+}
+
+/**
+ * @brief Show the result of a full sweep below the matrix and export it
+ */
+void ShowSweepResult(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, speed_level_t Level) {
+    // Display final results below the matrix, back on the Domain 1 frontier
+    MatrixViewSetTable(MinPWDForLAT, FrontierViolation);
+    MatrixViewClearText();
+    MatrixViewPrintf("Best LAT=%02X PWD=%02X PGS=%X RLS=%X\n", LAT, PWD, PGS, RLS);
+    MatrixViewPrintf("%lu.%02lu MB/s, model %lu%% of retail\n",
+                     (unsigned long)(BestKBPerSecMeasured / 1000), (unsigned long)((BestKBPerSecMeasured % 1000) / 10),
+                     (unsigned long)PiModelPercentOfRetail(LAT, PWD, PGS, RLS, MODEL_WORKLOAD_SIZE));
+    // Seconds from insertion to this page, in tenths
+    uint32_t ResultTenths = (uint32_t)(InsertToResultTicks / (TICKS_PER_SECOND / 10));
+    MatrixViewPrintf("Your cart %s (%lu.%lus)\n", SpeedLevelNames[Level],
+                     (unsigned long)(ResultTenths / 10), (unsigned long)(ResultTenths % 10));
+    
+    if (NumFrontierPoints > VerifyStepBacks) {
+        MatrixViewPrintf("Verified: %s, CIC %s", HeaderCrcValid ? "CRC1/CRC2" : "hash", RomCicName(CartCic));
+        if (VerifyStepBacks > 0) {
+            MatrixViewPrintf(", -%d", VerifyStepBacks);
+        }
+        MatrixViewPrintf("\n");
+    } else {
+        MatrixViewPrintf("No frontier point passed verification\n");
+    }
+    
+    // PI time the CPU did not have to wait for was overlapped with compares
+    const pidma_stats_t DmaStats = SweepDmaStats;
+    uint64_t HiddenTicks = (DmaStats.BusyTicks > DmaStats.WaitTicks) ?
+                           (DmaStats.BusyTicks - DmaStats.WaitTicks) : 0;
+    // CPU cycles are twice the C0 COUNT ticks
+    uint32_t ProbeCycles = (ProbeCount > 0) ? (uint32_t)(ProbeTicks * 2 / ProbeCount) : 0;
+    MatrixViewPrintf("Probes %lu @ %lu cyc, %lums PI hidden\n",
+                     (unsigned long)ProbeCount, (unsigned long)ProbeCycles,
+                     (unsigned long)(HiddenTicks / (TICKS_PER_SECOND / 1000)));
+    MatrixViewPrintf("Word: DMA %luns, PIO %luns, PIO>DMA %d\n",
+                     (unsigned long)DmaWordNs, (unsigned long)PioWordNs, PioStricterCount);
+#ifdef MARGIN_TEST
+    MatrixViewPrintf("Margin: %d marginal, guard +%d%s\n", MarginalLATCount, MARGIN_GUARD_PWD,
+                     MarginBudgetHit ? ", capped" : "");
+#endif
+    RenderModelCheck();
+    RenderThroughputTable();
+    MatrixViewPresent(true);
+    
+    debugf("Best: LAT=0x%02X PWD=0x%02X PGS=0x%X RLS=0x%X, %lu KB/s, cart %s\n",
+           LAT, PWD, PGS, RLS,
+           (unsigned long)BestKBPerSecMeasured, SpeedLevelNames[Level]);
+    debugf("DMA: %lu transfers, PI busy %lums, probes %lu at %lu cycles each\n",
+           (unsigned long)DmaStats.Transfers, (unsigned long)(DmaStats.BusyTicks / (TICKS_PER_SECOND / 1000)),
+           (unsigned long)ProbeCount, (unsigned long)ProbeCycles);
+    if (FrontierViolationCount > 0) {
+        debugf("PWD rose with LAT at %d LAT(s) (shown in red)\n", FrontierViolationCount);
+    }
+}
+
+/**
+ * @brief Show the header timing word for the chosen timing and what it saves at boot
+ *
+ * The first ROM word is the Domain 1 timing the IPL programs before it loads
+ * the game, so flashing the patched word into a cart image speeds up the boot
+ * load and every load of a game that keeps the header timing. The CRC1/CRC2
+ * checksum does not cover the header, so nothing else needs to change.
+ */
+void ShowHeaderPatch(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    header_patch_t Patch;
+    uint8_t StockLAT, StockPWD, StockPGS, StockRLS;
+    
+    RomParseTimingWord(StockHeaderWord, &StockLAT, &StockPWD, &StockPGS, &StockRLS);
+    MatrixViewClearText();
+    MatrixViewPrintf("Header timing patch (.z64 offset 0)\n");
+    MatrixViewPrintf("Stock   %08lX LAT%02X PWD%02X PGS%X RLS%X\n",
+                     (unsigned long)StockHeaderWord, StockLAT, StockPWD, StockPGS, StockRLS);
+    
+    if (LAT == 0xFF) {
+        MatrixViewPrintf("No passing timing, no patch\n");
+        MatrixViewPresent(true);
+        debugf("Header patch: no timing passed, no patch\n");
+        return;
+    }
+    if (!BuildHeaderPatch(LAT, PWD, PGS, RLS, &Patch)) {
+        MatrixViewPrintf("Stock timing is as fast, no patch\n");
+        MatrixViewPresent(true);
+        debugf("Header patch: stock word %08lX is already as fast as the tested timing\n", (unsigned long)StockHeaderWord);
+        return;
+    }
+    
+    uint32_t SavedUs = Patch.StockBootUs - Patch.PatchedBootUs;
+    MatrixViewPrintf("Patched %08lX LAT%02X PWD%02X PGS%X RLS%X\n",
+                     (unsigned long)Patch.PatchedWord, LAT, PWD, PGS, RLS);
+    MatrixViewPrintf("Boot 1MB: %lu.%lums -> %lu.%lums\n",
+                     (unsigned long)(Patch.StockBootUs / 1000), (unsigned long)((Patch.StockBootUs % 1000) / 100),
+                     (unsigned long)(Patch.PatchedBootUs / 1000), (unsigned long)((Patch.PatchedBootUs % 1000) / 100));
+    MatrixViewPrintf("Saves %lu.%lums per MB loaded (%lu%%)\n",
+                     (unsigned long)(SavedUs / 1000), (unsigned long)((SavedUs % 1000) / 100),
+                     (unsigned long)((uint64_t)SavedUs * 100 / Patch.StockBootUs));
+    MatrixViewPrintf("IPS patch sent over ISViewer\n");
+    MatrixViewPresent(true);
+    
+    debugf("Header patch: %08lX -> %08lX, 1MB boot load %lu us -> %lu us\n",
+           (unsigned long)Patch.StockWord, (unsigned long)Patch.PatchedWord,
+           (unsigned long)Patch.StockBootUs, (unsigned long)Patch.PatchedBootUs);
+    debugf("Header patch IPS (hex): %s\n", Patch.IpsHex);
+}
+
+/**
+ * @brief Show the PIO frontier in the matrix, LATs stricter than DMA in red
+ */
+void ShowPioFrontier(void) {
+    MatrixViewSetTable(PioMinPWDForLAT, PioStricter);
+    MatrixViewClearText();
+    MatrixViewPrintf("PIO (io_read) frontier\n");
+    MatrixViewPrintf("Red: PIO needs a higher PWD than DMA\n");
+    MatrixViewPrintf("%d LAT(s) stricter than DMA\n", PioStricterCount);
+    MatrixViewPrintf("Per word: DMA %luns, PIO %luns\n", (unsigned long)DmaWordNs, (unsigned long)PioWordNs);
+    MatrixViewPresent(true);
+}
+
+#ifdef MARGIN_TEST
+/**
+ * @brief Show the safe PWD table the margin test built
+ */
+void ShowMarginTable(void) {
+    MatrixViewSetTable(SafePWDForLAT, MarginalLAT);
+    MatrixViewClearText();
+    MatrixViewPrintf("Margin: safe PWD (reliable + %d)\n", MARGIN_GUARD_PWD);
+    MatrixViewPrintf("Red: single-pass minimum not reliable\n");
+    MatrixViewPrintf("%d marginal LAT(s), %lu probes\n", MarginalLATCount, (unsigned long)MarginProbes);
+    if (MarginBudgetHit) {
+        MatrixViewPrintf("Probe budget spent: LATs left \"--\"\n");
+        MatrixViewPrintf("were not margin tested\n");
+    }
+    MatrixViewPresent(true);
+}
+#endif
+
+/**
+ * @brief Show where the probe time goes, what the compare kernel costs and the probe rates
+ */
+void ShowProbeStats(void) {
+    const pidma_stats_t DmaStats = SweepDmaStats;
+    uint32_t ProbeCycles = (ProbeCount > 0) ? (uint32_t)(ProbeTicks * 2 / ProbeCount) : 0;
+    
+    MatrixViewSetTable(MinPWDForLAT, FrontierViolation);
+    MatrixViewClearText();
+    MatrixViewPrintf("Probe statistics\n");
+    MatrixViewPrintf("%lu probes @ %lu cyc, %lu DMAs\n",
+                     (unsigned long)ProbeCount, (unsigned long)ProbeCycles, (unsigned long)DmaStats.Transfers);
+    MatrixViewPrintf("Compare %uB (cycles): match / bad\n", NUM_TEST_LOCATIONS * BYTES_PER_LOCATION);
+    MatrixViewPrintf(" RomCompareLanes %6lu / %lu\n",
+                     (unsigned long)CompareBench.LanesMatch, (unsigned long)CompareBench.LanesMismatch);
+    MatrixViewPrintf(" memcmp          %6lu / %lu\n",
+                     (unsigned long)CompareBench.MemcmpMatch, (unsigned long)CompareBench.MemcmpMismatch);
+    if (CpuProbesPerSec > 0) {
+        MatrixViewPrintf("Probes/s at best: CPU %lu\n", (unsigned long)CpuProbesPerSec);
+#ifdef RSP_VERIFY
+        MatrixViewPrintf("Probes/s at best: RSP %lu\n", (unsigned long)RspProbesPerSec);
+#endif
+    }
+    MatrixViewPresent(true);
+}
+
+/**
+ * @brief Show the Domain 2 (save memory) frontier and its read throughput
+ */
+void ShowDom2Frontier(void) {
+    MatrixViewSetTable(Dom2MinPWDForLAT, NULL);
+    MatrixViewClearText();
+    MatrixViewPrintf("Domain 2 (save memory) frontier\n");
+    if (!Dom2Present) {
+        MatrixViewPrintf("No save memory answered\n");
+    } else if (!Dom2Identified) {
+        MatrixViewPrintf("Save not identified, not swept\n");
+    } else if (!Dom2Pattern) {
+        MatrixViewPrintf("No usable pattern (blank save)\n");
+    } else if (Dom2BestLAT == 0xFF) {
+        MatrixViewPrintf("No combination read back correctly\n");
+    } else {
+        MatrixViewPrintf("Best LAT=%02X PWD=%02X PGS=%X RLS=%X\n",
+                         Dom2BestLAT, Dom2BestPWD, DOM2_DEFAULT_PGS, DOM2_DEFAULT_RLS);
+        MatrixViewPrintf("Save read %lu KB/s vs %lu KB/s common\n",
+                         (unsigned long)Dom2KBPerSec, (unsigned long)Dom2DefaultKBPerSec);
+    }
+    MatrixViewPresent(true);
+}
+
+#ifdef WRITE_TEST
+/**
+ * @brief Show the Domain 1 write frontier and write throughput
+ */
+void ShowWriteFrontier(void) {
+    MatrixViewSetTable(WriteMinPWDForLAT, NULL);
+    MatrixViewClearText();
+    MatrixViewPrintf("Domain 1 write frontier\n");
+    if (!WritePresent) {
+        MatrixViewPrintf("No writable memory at %08X\n", WRITE_REGION_START);
+    } else if (WriteBestLAT == 0xFF) {
+        MatrixViewPrintf("No combination wrote correctly\n");
+    } else {
+        MatrixViewPrintf("Memory at %08X, read back slow\n", WRITE_REGION_START);
+        MatrixViewPrintf("Best LAT=%02X PWD=%02X PGS=7 RLS=3\n", WriteBestLAT, WriteBestPWD);
+        MatrixViewPrintf("Write %lu KB/s vs %lu KB/s retail\n",
+                         (unsigned long)WriteKBPerSec, (unsigned long)WriteDefaultKBPerSec);
+    }
+    MatrixViewPresent(true);
+}
+#endif
+
+#ifdef TRANSFER_PROFILES
+/**
+ * @brief Show the strictest transfer profile's frontier, LATs stricter than the samples in red
+ */
+void ShowTransferProfiles(void) {
+    MatrixViewSetTable(ProfileMinPWDForLAT[StrictestProfile], ProfileStricter);
+    MatrixViewClearText();
+    MatrixViewPrintf("Strictest transfer profile: %s\n", TransferProfileNames[StrictestProfile]);
+    MatrixViewPrintf("Red: needs a higher PWD than samples\n");
+    for (int Profile = 0; Profile < NUM_TRANSFER_PROFILES; Profile++) {
+        uint8_t LAT;
+        if (Profile != TRANSFER_SAMPLES && !(TRANSFER_PROFILES & (1 << Profile))) {
+            continue;
+        }
+        if (FastestFrontierCycles(ProfileMinPWDForLAT[Profile], &LAT) == 0xFFFFFFFF) {
+            MatrixViewPrintf("%-9s no working LAT\n", TransferProfileNames[Profile]);
+        } else {
+            MatrixViewPrintf("%-9s best LAT=%02X PWD=%02X\n", TransferProfileNames[Profile],
+                             LAT, ProfileMinPWDForLAT[Profile][LAT]);
+        }
+    }
+    MatrixViewPrintf("%d LAT(s) stricter than samples\n", ProfileStricterCount);
+    MatrixViewPresent(true);
+}
+#endif
+
+#ifdef CONTENTION_BENCH
+/**
+ * @brief Show the frontier under the worst RDRAM load and the chosen timing under every load
+ */
+void ShowContention(void) {
+    MatrixViewSetTable(LoadResults[WorstLoad].MinPWDForLAT, LoadStricter);
+    MatrixViewClearText();
+    MatrixViewPrintf("Frontier under RDRAM load: %s\n", BusLoadName((bus_load_t)WorstLoad));
+    MatrixViewPrintf("Red: higher PWD than display off\n");
+    MatrixViewPrintf("At LAT=%02X PWD=%02X PGS=%X RLS=%X:\n", ResultLAT, ResultPWD, ResultPGS, ResultRLS);
+    for (int Load = 0; Load < NUM_BUS_LOADS; Load++) {
+        const load_result_t * Result = &LoadResults[Load];
+        if (!Result->Measured) {
+            MatrixViewPrintf("%-5s not run\n", BusLoadName((bus_load_t)Load));
+            continue;
+        }
+        MatrixViewPrintf("%-5s %2lu.%02lu MB/s %s, %d stricter\n", BusLoadName((bus_load_t)Load),
+                         (unsigned long)(Result->KBPerSec / 1000), (unsigned long)((Result->KBPerSec % 1000) / 10),
+                         Result->Passes ? "ok" : "FAIL", Result->Stricter);
+    }
+    MatrixViewPresent(true);
+}
+#endif
+
+#ifdef DMA_LATENCY
+/**
+ * @brief Show the measured bus time per halfword at each LAT's minimum PWD
+ *
+ * Cells are in tens of ns, red where they are off the timing model. The same
+ * offset in every cell points to wait states added by the cart, cells that
+ * barely change with LAT and PWD to a cart that ignores the timing registers.
+ */
+void ShowLatencyMap(void) {
+    MatrixViewShowValues(LatencyTensOfNs, LatencyMismatch);
+    MatrixViewClearText();
+    MatrixViewPrintf("DMA ns per halfword / 10 at min PWD\n");
+    MatrixViewPrintf("Red: off the timing model\n");
+    MatrixViewPrintf("Cart %s\n", PiLatencyVerdictName(LatencySummary.Verdict));
+    if (LatencySummary.Verdict != PI_LATENCY_UNKNOWN) {
+        int32_t Offset = (LatencySummary.Offset16 < 0) ? -LatencySummary.Offset16 : LatencySummary.Offset16;
+        MatrixViewPrintf("Offset %c%ld.%02ld cyc/halfword, slope %ld%%\n",
+                         (LatencySummary.Offset16 < 0) ? '-' : '+', (long)(Offset / 16), (long)((Offset % 16) * 100 / 16),
+                         (long)LatencySummary.SlopePercent);
+        MatrixViewPrintf("%d of %d cells off, %lu cyc per DMA\n", LatencySummary.Mismatched, LatencySummary.Cells,
+                         (unsigned long)PiLatencyOverheadCycles());
+    }
+    MatrixViewPresent(true);
+}
+#endif
+
+#ifdef SHOW_LANE_MAP
+/**
+ * @brief Show which AD lines failed first at each LAT
+ *
+ * One line failing on its own across many LATs points to a weak data line
+ * (a cheap rework), many lines failing together to a general timing limit.
+ */
+void ShowLaneMap(void) {
+    int LaneLATs[16] = { 0 };  // LATs where only this line failed
+    int SingleLATs = 0;
+    int GeneralLATs = 0;
+    
+    for (int LAT = 0; LAT < 256; LAT++) {
+        uint16_t Lanes = FirstFailLanes[LAT];
+        if (Lanes == 0) {
+            continue;
+        }
+        if ((Lanes & (Lanes - 1)) == 0) {
+            LaneLATs[__builtin_ctz(Lanes)]++;
+            SingleLATs++;
+        } else {
+            GeneralLATs++;
+        }
+    }
+    
+    int Weakest = 0;
+    for (int Lane = 1; Lane < 16; Lane++) {
+        if (LaneLATs[Lane] > LaneLATs[Weakest]) {
+            Weakest = Lane;
+        }
+    }
+    
+    MatrixViewShowLanes(FirstFailLanes);
+    MatrixViewClearText();
+    MatrixViewPrintf("AD lines failing first at each LAT\n");
+    MatrixViewPrintf("One line (red): %d LATs, several: %d\n", SingleLATs, GeneralLATs);
+    if (LaneLATs[Weakest] > 0) {
+        MatrixViewPrintf("Weakest line: AD%d (%d LATs)\n", Weakest, LaneLATs[Weakest]);
+    } else {
+        MatrixViewPrintf("No single weak line\n");
+    }
+    MatrixViewPresent(true);
+    
+    for (int Row = 0; Row < 16; Row++) {
+        debugf("Lanes LAT %02X:", Row * 16);
+        for (int Col = 0; Col < 16; Col++) {
+            debugf(" %04X", FirstFailLanes[Row * 16 + Col]);
+        }
+        debugf("\n");
+    }
+}
+#endif
+
+/**
+ * @brief Read the header CRC1/CRC2 at slowest speed (the result cache key)
+ *
+ * Also keeps the header timing word in StockHeaderWord for the header patch.
+ */
+void CartReadHeaderCrcs(uint32_t * OutCrc1, uint32_t * OutCrc2) {
+    uint8_t HeaderData[32] __attribute__ ((aligned(16)));
+    
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    data_cache_hit_invalidate(HeaderData, sizeof(HeaderData));
+    CartDom1Read(HeaderData, 0, sizeof(HeaderData));
+    data_cache_hit_invalidate(HeaderData, sizeof(HeaderData));
+    
+    StockHeaderWord = RomReadWord(HeaderData + ROM_TIMING_OFFSET);
+    *OutCrc1 = RomReadWord(HeaderData + ROM_CRC1_OFFSET);
+    *OutCrc2 = RomReadWord(HeaderData + ROM_CRC2_OFFSET);
+}
+
+/**
+ * @brief Confirm a cached result with a short probe instead of the full sweep
+ *
+ * The cached best timing must still work on the cached sample blocks (DMA and PIO), and one
+ * PWD step faster than the cached frontier at the same LAT must still fail. A marginal
+ * frontier cell passes now and then, so the faster cell is probed several times and
+ * only a clear majority of passes counts as the frontier having moved.
+ * Otherwise the cart (or its contacts) changed and it gets a full sweep.
+ */
+bool ConfirmCachedResult(const result_cache_entry_t * Entry) {
+    // The export of a confirmed result reports these probes instead of a sweep
+    ProbeCount = 0;
+    PioProbeCount = 0;
+    ProbeTicks = 0;
+    PiDmaResetStats();
+    
+    // Kept if the confirmation fails, so the full sweep skips the sample scan
+    for (int i = 0; i < NUM_TEST_LOCATIONS; i++) {
+        SampleBlocks[i].Offset = Entry->SampleOffsets[i];
+        SampleBlocks[i].Toggles = 0;
+    }
+    SampleBlocksCached = true;
+    ReadReferenceData();
+    
+    bool Confirmed = TestSpeed(Entry->LAT, Entry->PWD, Entry->PGS, Entry->RLS) &&
+                     TestSpeedPio(Entry->LAT, Entry->PWD, Entry->PGS, Entry->RLS);
+    uint8_t FrontierPWD = Entry->MinPWDForLAT[Entry->LAT];
+    if (Confirmed && FrontierPWD != 0 && FrontierPWD != 0xFF) {
+        int FasterPasses = 0;
+        for (int i = 0; i < CONFIRM_FASTER_PROBES; i++) {
+            if (TestSpeed(Entry->LAT, FrontierPWD - 1, 0x07, 0x03)) {
+                FasterPasses++;
+            }
+        }
+        Confirmed = (FasterPasses < CONFIRM_FASTER_MAJORITY);
+        if (FasterPasses > 0) {
+            debugf("Cache: PWD 0x%02X at LAT 0x%02X passed %d of %d probes\n",
+                   FrontierPWD - 1, Entry->LAT, FasterPasses, CONFIRM_FASTER_PROBES);
+        }
+    }
+    
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    PiDmaGetStats(&SweepDmaStats);
+    CpuProbesPerSec = 0;
+    RspProbesPerSec = 0;
+    return Confirmed;
+}
+
+/**
+ * @brief Remember the result of a full sweep for when the cart is inserted again
+ */
+void StoreCachedResult(uint32_t Crc1, uint32_t Crc2, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, speed_level_t Level) {
+    static result_cache_entry_t Entry;
+    
+    Entry.Crc1 = Crc1;
+    Entry.Crc2 = Crc2;
+    memcpy(Entry.Name, CartridgeName, sizeof(Entry.Name));
+    Entry.LAT = LAT;
+    Entry.PWD = PWD;
+    Entry.PGS = PGS;
+    Entry.RLS = RLS;
+    Entry.Level = (uint8_t)Level;
+    Entry.KBPerSec = BestKBPerSecMeasured;
+    Entry.HeaderCrcValid = HeaderCrcValid;
+    for (int i = 0; i < NUM_TEST_LOCATIONS; i++) {
+        Entry.SampleOffsets[i] = SampleBlocks[i].Offset;
+    }
+    memcpy(Entry.MinPWDForLAT, MinPWDForLAT, sizeof(Entry.MinPWDForLAT));
+    memcpy(Entry.FirstFailLanes, FirstFailLanes, sizeof(Entry.FirstFailLanes));
+    memcpy(Entry.PioMinPWDForLAT, PioMinPWDForLAT, sizeof(Entry.PioMinPWDForLAT));
+    Entry.DmaWordNs = DmaWordNs;
+    Entry.PioWordNs = PioWordNs;
+    memcpy(Entry.Dom2MinPWDForLAT, Dom2MinPWDForLAT, sizeof(Entry.Dom2MinPWDForLAT));
+    Entry.Dom2Present = Dom2Present;
+    Entry.Dom2Pattern = Dom2Pattern;
+    Entry.Dom2Identified = Dom2Identified;
+    Entry.Dom2LAT = Dom2BestLAT;
+    Entry.Dom2PWD = Dom2BestPWD;
+    Entry.Dom2KBPerSec = Dom2KBPerSec;
+    Entry.Dom2DefaultKBPerSec = Dom2DefaultKBPerSec;
+    ResultCacheStore(&Entry);
+}
+
+/**
+ * @brief Show a confirmed cached result and export it
+ *
+ * Everything the CART record holds is restored from the entry or reset to
+ * "not run", so the record never carries state from the previous cart.
+ * @param ConfirmTicks Time the confirmation probes took
+ */
+void ShowCachedResult(const result_cache_entry_t * Entry, uint64_t ConfirmTicks) {
+    // Header CRCs and CIC for the record (a 4KB read at slowest speed)
+    VerifyInit();
+    HeaderCrcValid = Entry->HeaderCrcValid;
+    SweepTicks = ConfirmTicks;
+    FrontierViolationCount = 0;
+    VerifyStepBacks = 0;
+    NumFrontierPoints = 0;
+    
+    // Redraw the cached frontier
+    memcpy(MinPWDForLAT, Entry->MinPWDForLAT, sizeof(MinPWDForLAT));
+    memcpy(FirstFailLanes, Entry->FirstFailLanes, sizeof(FirstFailLanes));
+    memcpy(PioMinPWDForLAT, Entry->PioMinPWDForLAT, sizeof(PioMinPWDForLAT));
+    MarkPioStricter();
+    DmaWordNs = Entry->DmaWordNs;
+    PioWordNs = Entry->PioWordNs;
+    memcpy(Dom2MinPWDForLAT, Entry->Dom2MinPWDForLAT, sizeof(Dom2MinPWDForLAT));
+    Dom2Present = Entry->Dom2Present;
+    Dom2Pattern = Entry->Dom2Pattern;
+    Dom2Identified = Entry->Dom2Identified;
+    Dom2BestLAT = Entry->Dom2LAT;
+    Dom2BestPWD = Entry->Dom2PWD;
+    Dom2KBPerSec = Entry->Dom2KBPerSec;
+    Dom2DefaultKBPerSec = Entry->Dom2DefaultKBPerSec;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        FrontierViolation[LAT] = false;
+    }
+    BestKBPerSecMeasured = Entry->KBPerSec;
+#ifdef DMA_LATENCY
+    // Latencies are not cached; the latency page stays empty until the next full sweep
+    memset(LatencyNs, 0xFF, sizeof(LatencyNs));
+    memset(LatencyTensOfNs, 0xFF, sizeof(LatencyTensOfNs));
+    memset(LatencyMismatch, 0, sizeof(LatencyMismatch));
+    memset(&LatencySummary, 0, sizeof(LatencySummary));
+#endif
+#ifdef TRANSFER_PROFILES
+    // Only the samples frontier is cached
+    StrictestProfile = -1;
+    memset(ProfileMinPWDForLAT, 0xFF, sizeof(ProfileMinPWDForLAT));
+#endif
+#ifdef CONTENTION_BENCH
+    WorstLoad = -1;
+#endif
+#ifdef WRITE_TEST
+    WriteTested = false;
+#endif
+#ifdef MARGIN_TEST
+    MarginalLATCount = -1;
+#endif
+    MatrixViewBegin(CartridgeName, MinPWDForLAT, FrontierViolation);
+    
+    uint64_t AgeSeconds = (get_ticks() - Entry->StoredTicks) / TICKS_PER_SECOND;
+    MatrixViewPrintf("Best LAT=%02X PWD=%02X PGS=%X RLS=%X\n", Entry->LAT, Entry->PWD, Entry->PGS, Entry->RLS);
+    MatrixViewPrintf("%lu.%02lu MB/s, model %lu%% of retail\n",
+                     (unsigned long)(Entry->KBPerSec / 1000), (unsigned long)((Entry->KBPerSec % 1000) / 10),
+                     (unsigned long)PiModelPercentOfRetail(Entry->LAT, Entry->PWD, Entry->PGS, Entry->RLS, MODEL_WORKLOAD_SIZE));
+    MatrixViewPrintf("Your cart %s\n", SpeedLevelNames[Entry->Level]);
+    MatrixViewPrintf("Word: DMA %luns, PIO %luns, PIO>DMA %d\n",
+                     (unsigned long)DmaWordNs, (unsigned long)PioWordNs, PioStricterCount);
+    MatrixViewPrintf("Cached %lus ago, confirmed in %lums\n",
+                     (unsigned long)AgeSeconds, (unsigned long)(ConfirmTicks / (TICKS_PER_SECOND / 1000)));
+    MatrixViewPrintf("Insertion to result: %lums\n", (unsigned long)(InsertToResultTicks / (TICKS_PER_SECOND / 1000)));
+    MatrixViewPresent(true);
+    
+    debugf("Cache hit: %s LAT=0x%02X PWD=0x%02X PGS=0x%X RLS=0x%X, stored %lus ago\n",
+           CartridgeName, Entry->LAT, Entry->PWD, Entry->PGS, Entry->RLS, (unsigned long)AgeSeconds);
+    ExportCartResult(Entry->LAT, Entry->PWD, Entry->PGS, Entry->RLS, (speed_level_t)Entry->Level, Entry);
 }
 
+#ifdef SOAK_SECONDS
 /**
- * @brief Read cartridge name from ROM header
+ * @brief Store the slow-speed hash of one soak chunk
  */
-bool CartReadName(char * NameBuffer, size_t BufferSize) {
-    if (NameBuffer == NULL || BufferSize < 21) {
-        return false;
+static void SoakReferenceCallback(const uint8_t * Data, uint32_t Offset, uint32_t Len, void * Context) {
+    SoakChunkHash[(Offset - SOAK_REGION_START) / STREAM_CHUNK_SIZE] = RomHashUpdate(ROM_HASH_SEED, Data, Len);
+}
+
+/**
+ * @brief Compare one chunk read at the soaked timing with its slow-speed hash
+ */
+static void SoakCheckCallback(const uint8_t * Data, uint32_t Offset, uint32_t Len, void * Context) {
+    if (RomHashUpdate(ROM_HASH_SEED, Data, Len) == SoakChunkHash[(Offset - SOAK_REGION_START) / STREAM_CHUNK_SIZE]) {
+        return;
     }
     
-    uint8_t NameData[32] __attribute__ ((aligned(16)));
-    data_cache_hit_invalidate(NameData, sizeof(NameData));
-    CartDom1Read(NameData, 0x20, sizeof(NameData));
-    data_cache_hit_invalidate(NameData, sizeof(NameData));
-    
-    // Copy and validate name
-    bool HasValidChars = false;
-    for (int i = 0; i < 20; i++) {
-        if (NameData[i] >= 0x20 && NameData[i] <= 0x7E) {
-            HasValidChars = true;
-        }
-        NameBuffer[i] = NameData[i];
+    // Counted once the pass is over and the cart is known to still be there
+    if (Soak.PassErrors == 0) {
+        Soak.PassErrorTicks = get_ticks();
+        Soak.PassErrorOffset = Offset;
     }
-    NameBuffer[20] = '\0';  // Ensure null termination
-    
-    return HasValidChars;
+    Soak.PassErrors++;
 }
 
 /**
- * @brief Read reference data at slowest speed
+ * @brief Highlight the LAT being soaked in the matrix
  */
-void ReadReferenceData(void) {
-    // Set to slowest speed
-    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+static void SoakMarkLAT(uint8_t LAT, bool Marked) {
+    SoakMarks[LAT] = Marked;
+    MatrixViewMarkCell(LAT);
+}
+
+/**
+ * @brief Lowest PWD known to work at a LAT with the soaked PGS/RLS, 0xFF if none
+ *
+ * The frontier tables are for PGS 7/RLS 3 (the minimum PWD that works for both
+ * DMA and PIO). Other PGS/RLS values were only probed at the PGS/RLS search
+ * points, so for those the frontier is the search points and the cell the
+ * soak started at.
+ */
+static uint8_t SoakFrontierPWD(int LAT) {
+    if (Soak.PGS == 0x07 && Soak.RLS == 0x03) {
+        return (PioMinPWDForLAT[LAT] > MinPWDForLAT[LAT]) ? PioMinPWDForLAT[LAT] : MinPWDForLAT[LAT];
+    }
     
-    // Read 128 bytes from 4 locations across the 8MB span
-    // Read length must be a multiple of 16 bytes (128 is a multiple of 16)
-    for (int i = 0; i < NUM_TEST_LOCATIONS; i++) {
-        uint32_t Address = CART_DOM1_START + (i * ADDRESS_SPACING);
-        uint32_t Offset = Address - CART_DOM1_START;
-        
-        data_cache_hit_invalidate(ReferenceData[i], BYTES_PER_LOCATION);
-        CartDom1Read(ReferenceData[i], Offset, BYTES_PER_LOCATION);
-        data_cache_hit_invalidate(ReferenceData[i], BYTES_PER_LOCATION);
+    uint8_t MinPWD = (LAT == Soak.StartLAT) ? Soak.StartPWD : 0xFF;
+    for (int i = 0; i < NumFrontierPoints; i++) {
+        const frontier_point_t * Point = &FrontierPoints[i];
+        if (Point->LAT == LAT && Point->PGS == Soak.PGS && Point->RLS == Soak.RLS && Point->PWD < MinPWD) {
+            MinPWD = Point->PWD;
+        }
     }
+    return MinPWD;
 }
 
 /**
- * @brief Test a specific LAT/PWD speed combination
+ * @brief Move the soak to the fastest timing predicted slower than the one that failed
+ *
+ * Each step back adds one more PWD step on top of the frontier of the soaked
+ * PGS/RLS, so the soak moves away from the frontier instead of retrying a
+ * neighbouring cell on it, and keeps the PGS/RLS it was qualifying.
+ * @return false if SOAK_MAX_STEPBACKS is used up or no slower timing is left
  */
-bool TestSpeed(uint8_t LAT, uint8_t PWD) {
-    // Set speed
-    SetDom1Speed(LAT, PWD, 0x07, 0x03);
+static bool SoakStepBack(void) {
+    uint32_t FailedCycles = PiModelCycles(Soak.LAT, Soak.PWD, Soak.PGS, Soak.RLS, MODEL_WORKLOAD_SIZE);
+    uint32_t BestCycles = 0xFFFFFFFF;
+    int BestLAT = -1;
+    uint8_t BestPWD = 0xFF;
     
-    // Read 128 bytes from 4 locations and compare with reference data
-    // Read length must be a multiple of 16 bytes (128 is a multiple of 16)
-    uint8_t ReadBuffer[BYTES_PER_LOCATION] __attribute__ ((aligned(16)));
+    Soak.StepBacks++;
+    if (Soak.StepBacks > SOAK_MAX_STEPBACKS) {
+        return false;
+    }
     
-    for (int i = 0; i < NUM_TEST_LOCATIONS; i++) {
-        uint32_t Address = CART_DOM1_START + (i * ADDRESS_SPACING);
-        uint32_t Offset = Address - CART_DOM1_START;
-        
-        data_cache_hit_writeback_invalidate(ReadBuffer, BYTES_PER_LOCATION);
-        CartDom1Read(ReadBuffer, Offset, BYTES_PER_LOCATION);
-        data_cache_hit_writeback_invalidate(ReadBuffer, BYTES_PER_LOCATION);
-        
-        // Compare all 128 bytes with reference data (read at slowest speed)
-        if (memcmp(ReadBuffer, ReferenceData[i], BYTES_PER_LOCATION) != 0) {
-            return false;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        uint8_t MinPWD = SoakFrontierPWD(LAT);
+        if (MinPWD == 0xFF || MinPWD + Soak.StepBacks >= 0xFF) {
+            continue;
         }
+        uint8_t PWD = (uint8_t)(MinPWD + Soak.StepBacks);
+        uint32_t Cycles = PiModelCycles((uint8_t)LAT, PWD, Soak.PGS, Soak.RLS, MODEL_WORKLOAD_SIZE);
+        if (Cycles > FailedCycles && Cycles < BestCycles) {
+            BestCycles = Cycles;
+            BestLAT = LAT;
+            BestPWD = PWD;
+        }
+    }
+    if (BestLAT < 0) {
+        return false;
     }
     
+    debugf("Soak: stepping back from LAT=0x%02X PWD=0x%02X to LAT=0x%02X PWD=0x%02X\n",
+           Soak.LAT, Soak.PWD, BestLAT, BestPWD);
+    SoakMarkLAT(Soak.LAT, false);
+    Soak.LAT = (uint8_t)BestLAT;
+    Soak.PWD = BestPWD;
+    SoakMarkLAT(Soak.LAT, true);
+    Soak.TimingTicks = get_ticks();
     return true;
 }
 
 /**
- * @brief Map LAT/PWD values to speed level
+ * @brief Show the soak counters below the matrix
+ * @param Status First line, e.g. whether the soak is still running
  */
-speed_level_t MapSpeedToLevel(uint8_t LAT, uint8_t PWD) {
-    // Find the closest matching speed level
-    // We'll match based on which level's LAT/PWD values are closest
-    speed_level_t BestLevel = SPEED_LEVEL_TOTAL_POS;
-    int BestDistance = 0xFFFF;
+static void SoakShowProgress(const char * Status) {
+    uint64_t Now = get_ticks();
+    uint32_t Clean = (uint32_t)((Now - Soak.TimingTicks) / TICKS_PER_SECOND);
+    uint32_t MB = (uint32_t)(Soak.BytesRead / 1000000);
+    uint32_t KBPerSec = (Now > Soak.StartTicks) ?
+                        (uint32_t)(Soak.BytesRead / 1000 * TICKS_PER_SECOND / (Now - Soak.StartTicks)) : 0;
+    // Errors per GB in thousandths
+    uint32_t MilliPerGB = (MB > 0) ? (uint32_t)((uint64_t)Soak.Errors * 1000000 / MB) : 0;
     
-    for (speed_level_t Level = SPEED_LEVEL_TOTAL_POS; Level < NUM_SPEED_LEVELS; Level++) {
-        // Calculate distance (sum of absolute differences)
-        int LatDiff = (LAT > SpeedLevelLAT[Level]) ? (LAT - SpeedLevelLAT[Level]) : (SpeedLevelLAT[Level] - LAT);
-        int PwdDiff = (PWD > SpeedLevelPWD[Level]) ? (PWD - SpeedLevelPWD[Level]) : (SpeedLevelPWD[Level] - PWD);
-        int Distance = LatDiff + PwdDiff;
-        
-        // Prefer exact match or closest match
-        if (Distance < BestDistance) {
-            BestDistance = Distance;
-            BestLevel = Level;
-        }
+    Soak.DisplayTicks = Now;
+    MatrixViewClearText();
+    MatrixViewPrintf("%s\n", Status);
+    MatrixViewPrintf("Soak LAT=%02X PWD=%02X PGS=%X RLS=%X\n", Soak.LAT, Soak.PWD, Soak.PGS, Soak.RLS);
+    MatrixViewPrintf("Clean %lu:%02lu of %lu:%02lu, step backs %d\n",
+                     (unsigned long)(Clean / 60), (unsigned long)(Clean % 60),
+                     (unsigned long)(SOAK_SECONDS / 60), (unsigned long)(SOAK_SECONDS % 60), Soak.StepBacks);
+    MatrixViewPrintf("Read %lu.%02lu GB at %lu.%02lu MB/s\n",
+                     (unsigned long)(MB / 1000), (unsigned long)((MB % 1000) / 10),
+                     (unsigned long)(KBPerSec / 1000), (unsigned long)((KBPerSec % 1000) / 10));
+    MatrixViewPrintf("Errors %lu, %lu.%03lu per GB\n", (unsigned long)Soak.Errors,
+                     (unsigned long)(MilliPerGB / 1000), (unsigned long)(MilliPerGB % 1000));
+    if (Soak.Errors > 0) {
+        uint32_t FirstError = (uint32_t)(Soak.FirstErrorTicks / TICKS_PER_SECOND);
+        MatrixViewPrintf("First error after %lu:%02lu\n", (unsigned long)(FirstError / 60), (unsigned long)(FirstError % 60));
+    } else {
+        MatrixViewPrintf("No errors yet\n");
     }
-    
-    return BestLevel;
+    MatrixViewPresent(false);
 }
 
 /**
- * @brief Calculate speed metric (lower is better)
- * Uses LAT + PWD sum to minimize both parameters equally
+ * @brief Read the soak reference at slowest speed and start soaking a timing
  */
-static uint32_t CalculateSpeedMetric(uint8_t LAT, uint8_t PWD) {
-    return (uint32_t)LAT + (uint32_t)PWD * 2;
+void SoakBegin(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    memset(&Soak, 0, sizeof(Soak));
+    Soak.LAT = LAT;
+    Soak.PWD = PWD;
+    Soak.PGS = PGS;
+    Soak.RLS = RLS;
+    Soak.StartLAT = LAT;
+    Soak.StartPWD = PWD;
+    
+    memset(SoakMarks, 0, sizeof(SoakMarks));
+    SoakMarks[LAT] = true;
+    MatrixViewBegin(CartridgeName, MinPWDForLAT, SoakMarks);
+    MatrixViewPrintf("Soak: reading reference...\n");
+    MatrixViewPresent(true);
+    
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    CartDom1Stream(SOAK_REGION_START, SOAK_REGION_SIZE, SoakReferenceCallback, NULL);
+    
+    Soak.StartTicks = get_ticks();
+    Soak.TimingTicks = Soak.StartTicks;
+    debugf("Soak: %lus at LAT=0x%02X PWD=0x%02X PGS=0x%X RLS=0x%X over %lu KB\n",
+           (unsigned long)SOAK_SECONDS, LAT, PWD, PGS, RLS, (unsigned long)(SOAK_REGION_SIZE / 1024));
 }
 
 /**
- * @brief Render the 16x16 speed matrix (256 LAT values displayed as 16x16 grid)
+ * @brief Read the soak region once at the soaked timing and step back if it had errors
+ * @return true when the soak is over (the timing stayed clean for SOAK_SECONDS, or none did)
  */
-void RenderSpeedMatrix(void) {
-    // Clear screen and show header
-    console_clear();
-    printf("Domain 1 Speed Test\n");
-    printf("\nCartridge: %s\n", CartridgeName);
-    printf("\nSpeed Matrix (LAT 0-255, showing min PWD):\n");
-    printf("      ");
-    // Print column header (LAT offset within row: 0x0, 0x1, ..., 0xF)
-    // Use 3 spaces per column to align with 2-digit hex values
-    for (int Col = 0; Col < 16; Col++) {
-        printf(" %X ", Col);
+bool SoakPass(void) {
+    Soak.PassErrors = 0;
+    SetDom1Speed(Soak.LAT, Soak.PWD, Soak.PGS, Soak.RLS);
+    CartDom1Stream(SOAK_REGION_START, SOAK_REGION_SIZE, SoakCheckCallback, NULL);
+    SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+    if (Soak.PassErrors > 0 && !CartProbePresence()) {
+        // Pulled mid-pass: the bad chunks are not the timing's fault, and the
+        // state machine reports the removal on its next call
+        return false;
     }
-    printf("\n");
+    Soak.BytesRead += SOAK_REGION_SIZE;
+    Soak.Passes++;
     
-    // Print matrix rows: each row represents 16 LAT values
-    // Row 0: LAT 0x00-0x0F, Row 1: LAT 0x10-0x1F, etc.
-    for (int Row = 0; Row < 16; Row++) {
-        int BaseLAT = Row * 16;
-        printf("LAT%02X: ", BaseLAT);
-        for (int Col = 0; Col < 16; Col++) {
-            int LAT = BaseLAT + Col;
-            if (MinPWDForLAT[LAT] != 0xFF) {
-                // Show the minimum PWD value for this LAT
-                printf("%02X ", MinPWDForLAT[LAT]);
-            } else {
-                printf("-- ");  // No working PWD found
-            }
+    bool Done = false;
+    if (Soak.PassErrors > 0) {
+        if (Soak.Errors == 0) {
+            Soak.FirstErrorTicks = Soak.PassErrorTicks - Soak.StartTicks;
         }
-        printf("\n");
+        Soak.Errors += Soak.PassErrors;
+        // First bad chunk of each pass only, a failing timing breaks most of them
+        debugf("Soak: chunk at 0x%06lX wrong at LAT=0x%02X PWD=0x%02X after %lus\n",
+               (unsigned long)Soak.PassErrorOffset, Soak.LAT, Soak.PWD,
+               (unsigned long)((Soak.PassErrorTicks - Soak.TimingTicks) / TICKS_PER_SECOND));
+        debugf("Soak: pass %lu had %lu bad chunk(s)\n", (unsigned long)Soak.Passes, (unsigned long)Soak.PassErrors);
+        Soak.Failed = !SoakStepBack();
+        Done = Soak.Failed;
+    } else {
+        Done = (get_ticks() - Soak.TimingTicks >= (uint64_t)SOAK_SECONDS * TICKS_PER_SECOND);
     }
-    console_render();
+    
+    // Live counters about once a second, and right away after an error
+    if (!Done && (Soak.PassErrors > 0 || get_ticks() - Soak.DisplayTicks >= TICKS_PER_SECOND)) {
+        SoakShowProgress("Soaking...");
+    }
+    return Done;
 }
 
 /**
- * @brief Run speed test - find minimum working PWD for each LAT (0-255), displayed as 16x16 grid
- * @param OutLAT Output parameter for fastest working LAT value (best overall)
- * @param OutPWD Output parameter for fastest working PWD value (best overall)
- * @return Speed level corresponding to the fastest working combination
+ * @brief Show and export the outcome of the soak, and cache the timing it qualified
  */
-speed_level_t RunSpeedTest(uint8_t * OutLAT, uint8_t * OutPWD) {
-    // Read reference data at slowest speed
-    ReadReferenceData();
+void FinishSoak(void) {
+    uint32_t Crc1, Crc2;
+    header_patch_t Patch;
     
-    // Initialize matrix - all 256 LAT values
-    for (int LAT = 0; LAT < 256; LAT++) {
-        MinPWDForLAT[LAT] = 0xFF;  // 0xFF means no working PWD found
+    SoakShowProgress(Soak.Failed ? "Soak failed, no timing stayed clean" : "Soak passed, timing qualified");
+    if (!Soak.Failed && BuildHeaderPatch(Soak.LAT, Soak.PWD, Soak.PGS, Soak.RLS, &Patch)) {
+        MatrixViewPrintf("Header word %08lX\n", (unsigned long)Patch.PatchedWord);
     }
+    MatrixViewPresent(true);
     
-    // Clear screen and show initial matrix
-    console_clear();
-    printf("Domain 1 Speed Test\n");
-    printf("\nCartridge: %s\n", CartridgeName);
-    printf("\nTesting speeds...\n");
-    RenderSpeedMatrix();
+    debugf("Soak: %s at LAT=0x%02X PWD=0x%02X, %lu error(s) in %lu MB, %d step back(s)\n",
+           Soak.Failed ? "failed" : "passed", Soak.LAT, Soak.PWD, (unsigned long)Soak.Errors,
+           (unsigned long)(Soak.BytesRead / 1000000), Soak.StepBacks);
     
-    uint8_t BestLAT = 0xFF;
-    uint8_t BestPWD = 0xFF;
-    uint32_t BestMetric = 0xFFFFFFFF;
+    CartReadHeaderCrcs(&Crc1, &Crc2);
+    ExportBegin("SOAK");
+    ExportLine("HDR crc1=%08lX crc2=%08lX", (unsigned long)Crc1, (unsigned long)Crc2);
+    ExportLine("SOAK lat=%02X pwd=%02X pgs=%X rls=%X passed=%d seconds=%lu region_kb=%lu",
+               Soak.LAT, Soak.PWD, Soak.PGS, Soak.RLS, Soak.Failed ? 0 : 1,
+               (unsigned long)((get_ticks() - Soak.StartTicks) / TICKS_PER_SECOND),
+               (unsigned long)(SOAK_REGION_SIZE / 1024));
+    ExportLine("ERR errors=%lu mb=%lu first_error_s=%lu stepbacks=%d",
+               (unsigned long)Soak.Errors, (unsigned long)(Soak.BytesRead / 1000000),
+               (unsigned long)(Soak.FirstErrorTicks / TICKS_PER_SECOND), Soak.StepBacks);
+    ExportEnd();
     
-    // Test all 256 LAT values (0-255)
-    for (int LAT = 0; LAT < 256; LAT++) {
-        // For each LAT, find the minimum working PWD (0-255)
-        for (int PWD = 0; PWD < 256; PWD++) {
-            // Test this combination
-            bool Works = TestSpeed((uint8_t)LAT, (uint8_t)PWD);
-            
-            if (Works) {
-                // Update minimum PWD for this LAT
-                if (MinPWDForLAT[LAT] == 0xFF || PWD < MinPWDForLAT[LAT]) {
-                    // New minimum PWD found - update and render
-                    MinPWDForLAT[LAT] = (uint8_t)PWD;
-                    RenderSpeedMatrix();
-                }
-                
-                // Check if this is the best overall combination
-                uint32_t Metric = CalculateSpeedMetric((uint8_t)LAT, (uint8_t)PWD);
-                if (Metric < BestMetric) {
-                    BestMetric = Metric;
-                    BestLAT = (uint8_t)LAT;
-                    BestPWD = (uint8_t)PWD;
-                }
-            }
+    // A re-inserted cart should confirm the timing that survived, not the one that did not
+    result_cache_entry_t * Cached = ResultCacheFind(Crc1, Crc2, CartridgeName);
+    if (Soak.Failed) {
+        if (Cached != NULL) {
+            ResultCacheRemove(Cached);
         }
+    } else if (Soak.StepBacks > 0) {
+        BestKBPerSecMeasured = MeasureThroughput(&Dom1Bench, Soak.LAT, Soak.PWD, Soak.PGS, Soak.RLS, BENCH_REPEATS);
+        SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
+        StoreCachedResult(Crc1, Crc2, Soak.LAT, Soak.PWD, Soak.PGS, Soak.RLS,
+                          MapSpeedToLevel(Soak.LAT, Soak.PWD, Soak.PGS, Soak.RLS));
+    }
+}
+#endif
+
+/**
+ * @brief Timer callback: the state machine's next deadline has passed
+ */
+static void WakeCallback(int Overflow) {
+    WakePending = true;
+}
+
+/**
+ * @brief Interval until the next presence poll, doubling while nothing changes
+ */
+static uint32_t NextPollMs(void) {
+    uint32_t Interval = PollMs;
+    PollMs = (PollMs * 2 < POLL_MAX_MS) ? PollMs * 2 : POLL_MAX_MS;
+    return Interval;
+}
+
+/**
+ * @brief Show one result page
+ * @return false if the page is not built in or has nothing to show
+ */
+static bool ShowResultPage(result_page_t Page) {
+    switch (Page) {
+        case PAGE_HEADER_PATCH:
+            // The header timing word for the chosen timing
+            ShowHeaderPatch(ResultLAT, ResultPWD, ResultPGS, ResultRLS);
+            return true;
         
-        // After completing a full row (16 consecutive LAT values), check if they all have the same PWD
-        if ((LAT % 16) == 15) {
-            // We just completed a row (e.g., LAT 0-15, 16-31, etc.)
-            int RowStart = LAT - 15;  // Start of this row
-            uint8_t FirstPWD = MinPWDForLAT[RowStart];
-            bool AllSame = (FirstPWD != 0xFF);
-            
-            if (AllSame) {
-                // Check if all 16 LAT values in this row have the same PWD
-                for (int i = 1; i < 16; i++) {
-                    if (MinPWDForLAT[RowStart + i] != FirstPWD) {
-                        AllSame = false;
-                        break;
-                    }
-                }
+        case PAGE_MARGIN:
+#ifdef MARGIN_TEST
+            // Safe PWD per LAT against the single-pass minimum; not shown for a cached result
+            if (MarginalLATCount >= 0) {
+                ShowMarginTable();
+                return true;
             }
-            
-            // If all 16 LAT values in this row have the same PWD, assume the rest will too
-            if (AllSame && LAT < 255) {
-                // Fill remaining LAT values with the same PWD
-                for (int RemainingLAT = LAT + 1; RemainingLAT < 256; RemainingLAT++) {
-                    MinPWDForLAT[RemainingLAT] = FirstPWD;
-                }
-                RenderSpeedMatrix();
-                break;  // Exit the LAT loop
+#endif
+            return false;
+        
+        case PAGE_PIO_FRONTIER:
+            ShowPioFrontier();
+            return true;
+        
+        case PAGE_DOM2_FRONTIER:
+            // The save memory (Domain 2) frontier
+            ShowDom2Frontier();
+            return true;
+        
+        case PAGE_WRITE_FRONTIER:
+#ifdef WRITE_TEST
+            // The write frontier; not shown for a cached result
+            if (WriteTested) {
+                ShowWriteFrontier();
+                return true;
             }
-        }
-    }
-    
-    // Map the best working LAT/PWD to a speed level
-    if (BestLAT != 0xFF && BestPWD != 0xFF) {
-        if (OutLAT != NULL) {
-            *OutLAT = BestLAT;
-        }
-        if (OutPWD != NULL) {
-            *OutPWD = BestPWD;
-        }
-        return MapSpeedToLevel(BestLAT, BestPWD);
-    } else {
-        // No working speed found (shouldn't happen, but handle it)
-        if (OutLAT != NULL) {
-            *OutLAT = 0xFF;
-        }
-        if (OutPWD != NULL) {
-            *OutPWD = 0xFF;
-        }
-        return SPEED_LEVEL_TOTAL_POS;
+#endif
+            return false;
+        
+        case PAGE_TRANSFER_PROFILES:
+#ifdef TRANSFER_PROFILES
+            // The frontier of the strictest DMA shape; not shown for a cached result
+            if (StrictestProfile >= 0) {
+                ShowTransferProfiles();
+                return true;
+            }
+#endif
+            return false;
+        
+        case PAGE_CONTENTION:
+#ifdef CONTENTION_BENCH
+            // PI bandwidth and frontier under RDRAM loads; not shown for a cached result
+            if (WorstLoad >= 0) {
+                ShowContention();
+                return true;
+            }
+#endif
+            return false;
+        
+        case PAGE_LANE_MAP:
+#ifdef SHOW_LANE_MAP
+            // Failing AD lines instead of minimum PWD
+            ShowLaneMap();
+            return true;
+#else
+            return false;
+#endif
+        
+        case PAGE_LATENCY_MAP:
+#ifdef DMA_LATENCY
+            // Measured DMA time per halfword against the timing model
+            ShowLatencyMap();
+            return true;
+#else
+            return false;
+#endif
+        
+        case PAGE_SOAK:
+#ifdef SOAK_SECONDS
+            // Qualify the chosen timing before the cart is removed; the soak runs
+            // in its own state and comes back here with its outcome on screen
+            if (ResultLAT != 0xFF) {
+                SoakBegin(ResultLAT, ResultPWD, ResultPGS, ResultRLS);
+                CurrentState = STATE_SOAK;
+                return true;
+            }
+#endif
+            return false;
+        
+        case PAGE_PROBE_STATS:
+            // Probe cost and the compare kernel against memcmp
+            ShowProbeStats();
+            return true;
+        
+        case PAGE_PROFILE:
+            // Hand the screen back to the console
+            MatrixViewEnd();
+#ifdef PROFILE_PHASES
+            // Summary page of where the sweep time went
+            ProfilePrintSummary();
+            return true;
+#else
+            return false;
+#endif
+        
+        default:
+            return false;
     }
 }
 
@@ -457,8 +3699,20 @@ static void ResetCallback(void) {
 
 /**
  * @brief Handle state machine
+ *
+ * Every call does a bounded amount of work; waiting is left to main.
+ * @return Milliseconds until the state machine wants to run again, 0 for right away
  */
-void HandleStateMachine(void) {
+uint32_t HandleStateMachine(void) {
+    uint32_t WakeMs = 0;
+    
+    // Polls start fast again whenever the state changes
+    bool Entered = (CurrentState != PreviousState);
+    PreviousState = CurrentState;
+    if (Entered) {
+        PollMs = POLL_MIN_MS;
+    }
+    
     switch (CurrentState) {
         case STATE_INIT: {
             // Initialize display
@@ -472,6 +3726,13 @@ void HandleStateMachine(void) {
             rdpq_init();
             console_init();
             debug_init_isviewer();
+            PiDmaInit();
+            ProbeArenaInit();
+            MeasureCompareKernel();
+#ifdef RSP_VERIFY
+            // Compares stay on the CPU if the RSP fails its self-test
+            RspVerifyInit();
+#endif
             
             // Set default Domain 1 speed
             SetDom1Speed(DEFAULT_DOM1_LAT, DEFAULT_DOM1_PWD, 0x07, 0x03);
@@ -508,14 +3769,20 @@ void HandleStateMachine(void) {
         }
         
         case STATE_SAFE_REMOVE: {
-            printf("\nSafe to remove cartridge\n");
-            console_render();
+            if (Entered) {
+                printf("\nSafe to remove cartridge\n");
+                if (InsertToResultTicks > 0) {
+                    printf("Insertion to result: %lums\n",
+                           (unsigned long)(InsertToResultTicks / (TICKS_PER_SECOND / 1000)));
+                }
+                console_render();
+            }
             
 #ifndef RUN_ON_EMULATOR
             // Wait until cartridge is actually removed
-            while (CartDetectPresence()) {
-                // Cartridge still present, keep waiting
-                for (volatile int i = 0; i < 100000; i++);  // Small delay between checks
+            if (CartProbePresence()) {
+                WakeMs = NextPollMs();
+                break;
             }
 #endif
             
@@ -525,26 +3792,39 @@ void HandleStateMachine(void) {
         }
         
         case STATE_DETECT: {
-            if (!CartDetectPresence()) {
-                // No cartridge
+            if (Entered) {
+                InsertTicks = 0;
                 console_clear();
                 printf("Domain 1 Speed Test\n");
                 printf("\nNo cartridge inserted\n");
                 console_render();
+            }
+            
+            if (!CartProbePresence()) {
+                // No cartridge
+                InsertTicks = 0;
+                WakeMs = NextPollMs();
+                break;
+            }
+            
+            // Give the contacts a moment after the cart first shows up
+            if (InsertTicks == 0) {
+                InsertTicks = get_ticks();
+                WakeMs = INSERT_SETTLE_MS;
+                break;
+            }
+            
+            // Cartridge detected
+            if (CartDetectPresence() && CartReadName(CartridgeName, sizeof(CartridgeName))) {
+                console_clear();
+                printf("Domain 1 Speed Test\n");
+                printf("\nNew cartridge detected\n");
+                printf("Name: %s\n", CartridgeName);
+                console_render();
+                
+                CurrentState = STATE_TEST;
             } else {
-                // Cartridge detected
-                if (CartReadName(CartridgeName, sizeof(CartridgeName))) {
-                    console_clear();
-                    printf("Domain 1 Speed Test\n");
-                    printf("\nNew cartridge detected\n");
-                    printf("Name: %s\n", CartridgeName);
-                    console_render();
-                    
-                    // Wait a bit before starting test
-                    for (volatile int i = 0; i < 2000000; i++);
-                    
-                    CurrentState = STATE_TEST;
-                }
+                WakeMs = NextPollMs();
             }
             break;
         }
@@ -561,105 +3841,239 @@ void HandleStateMachine(void) {
                 break;
             }
             
-            uint8_t FastestLAT, FastestPWD;
-            speed_level_t Result = RunSpeedTest(&FastestLAT, &FastestPWD);
+            uint8_t FastestLAT, FastestPWD, FastestPGS, FastestRLS;
+            speed_level_t Result;
+            bool Swept = false;
+            
+            // A cart tested earlier in this session only needs a confirmation probe
+            uint32_t HeaderCrc1, HeaderCrc2;
+            CartReadHeaderCrcs(&HeaderCrc1, &HeaderCrc2);
+            result_cache_entry_t * Cached = ResultCacheFind(HeaderCrc1, HeaderCrc2, CartridgeName);
+            SampleBlocksCached = false;
+            uint64_t ConfirmStart = get_ticks();
+            if (Cached != NULL && ConfirmCachedResult(Cached)) {
+                FastestLAT = Cached->LAT;
+                FastestPWD = Cached->PWD;
+                FastestPGS = Cached->PGS;
+                FastestRLS = Cached->RLS;
+                Result = (speed_level_t)Cached->Level;
+                // The first result page shows it, so it is taken just before
+                InsertToResultTicks = get_ticks() - InsertTicks;
+                ShowCachedResult(Cached, get_ticks() - ConfirmStart);
+            } else {
+                if (Cached != NULL) {
+                    debugf("Cache: %s did not confirm its cached result, running full sweep\n", CartridgeName);
+                    ResultCacheRemove(Cached);
+                }
+                Result = RunSpeedTest(&FastestLAT, &FastestPWD, &FastestPGS, &FastestRLS);
+                Swept = true;
+                RunDom2Test();
+#ifdef WRITE_TEST
+                RunWriteTest();
+#endif
+                InsertToResultTicks = get_ticks() - InsertTicks;
+                ShowSweepResult(FastestLAT, FastestPWD, FastestPGS, FastestRLS, Result);
+                if (FastestLAT != 0xFF) {
+                    StoreCachedResult(HeaderCrc1, HeaderCrc2, FastestLAT, FastestPWD, FastestPGS, FastestRLS, Result);
+                }
+            }
+            debugf("Insertion to result: %lums\n", (unsigned long)(InsertToResultTicks / (TICKS_PER_SECOND / 1000)));
+            
+            // A swept result is exported once it is final, after the contention bench if that runs
+            bool BenchPending = false;
+#if defined(CONTENTION_BENCH) && !defined(RUN_ON_EMULATOR)
+            // The emulator loop below never reaches the bench state
+            BenchPending = Swept && (FastestLAT != 0xFF);
+#endif
+            if (Swept && !BenchPending) {
+                ExportCartResult(FastestLAT, FastestPWD, FastestPGS, FastestRLS, Result, NULL);
+            }
+            
+#ifdef RSP_VERIFY
+            // Let the RSP halt until the next cart
+            RspVerifyStop();
+#endif
             
             // Read 128 bytes using the fastest working speed
-            SetDom1Speed(FastestLAT, FastestPWD, 0x07, 0x03);
+            SetDom1Speed(FastestLAT, FastestPWD, FastestPGS, FastestRLS);
             uint8_t DisplayData[128] __attribute__ ((aligned(16)));
             data_cache_hit_invalidate(DisplayData, sizeof(DisplayData));
             CartDom1Read(DisplayData, 0, 128);
             data_cache_hit_invalidate(DisplayData, sizeof(DisplayData));
             
-            // Display final results with matrix
-            console_clear();
-            printf("Domain 1 Speed Test\n");
-            printf("\nCartridge: %s\n", CartridgeName);
-            printf("\nSpeed Matrix (LAT 0-255, showing min PWD):\n");
-            printf("      ");
-            // Print column header (LAT offset within row: 0x0, 0x1, ..., 0xF)
-            // Use 3 spaces per column to align with 2-digit hex values
-            for (int Col = 0; Col < 16; Col++) {
-                printf(" %X ", Col);
-            }
-            printf("\n");
-            
-            // Print matrix rows: each row represents 16 LAT values
-            // Row 0: LAT 0x00-0x0F, Row 1: LAT 0x10-0x1F, etc.
-            for (int Row = 0; Row < 16; Row++) {
-                int BaseLAT = Row * 16;
-                printf("LAT%02X: ", BaseLAT);
-                for (int Col = 0; Col < 16; Col++) {
-                    int LAT = BaseLAT + Col;
-                    if (MinPWDForLAT[LAT] != 0xFF) {
-                        // Show the minimum PWD value for this LAT
-                        printf("%02X ", MinPWDForLAT[LAT]);
-                    } else {
-                        printf("-- ");  // No working PWD found
-                    }
-                }
-                printf("\n");
-            }
-            
 #ifdef SHOW_REF_BYTES
-            printf("\nExpected 128 bytes (reference):\n");
+            // The screen is owned by the matrix view, so dump the bytes over ISViewer
+            debugf("Expected 128 bytes (reference):\n");
             
             // Display expected 128 bytes in hex format (16 bytes per line)
             for (int i = 0; i < 128; i += 16) {
-                printf("%04X: ", i);
+                debugf("%04X: ", i);
                 for (int j = 0; j < 16; j++) {
                     if (i + j < 128) {
-                        printf("%02X ", ReferenceData[0][i + j]);
+                        debugf("%02X ", ReferenceData[i + j]);
                     }
                 }
-                printf("\n");
+                debugf("\n");
             }
             
-            printf("\n128 bytes read at fastest speed:\n");
+            debugf("128 bytes read at fastest speed:\n");
             
             // Display 128 bytes in hex format (16 bytes per line)
             for (int i = 0; i < 128; i += 16) {
-                printf("%04X: ", i);
+                debugf("%04X: ", i);
                 for (int j = 0; j < 16; j++) {
                     if (i + j < 128) {
-                        printf("%02X ", DisplayData[i + j]);
+                        debugf("%02X ", DisplayData[i + j]);
                     }
                 }
-                printf("\n");
+                debugf("\n");
             }
 #endif
             
-            printf("\nBest overall speed:\n");
-            printf("LAT=0x%02X, PWD=0x%02X\n", FastestLAT, FastestPWD);
-            printf("Your cart %s\n", SpeedLevelNames[Result]);
-            console_render();
-            
             // Set Domain 1 speed back to slowest after test completes
             SetDom1Speed(0xFF, 0xFF, 0x07, 0x03);
             
 #ifdef RUN_ON_EMULATOR
             // In emulator mode, loop infinitely to keep results visible
-            printf("\nEmulator mode: Entering infinite loop\n");
-            console_render();
+            debugf("Emulator mode: Entering infinite loop\n");
             while (1) {
                 // Infinite loop - keep results visible
             }
 #endif
-            // Wait before returning to detection
-            for (volatile int i = 0; i < 5000000; i++);
+            // The results page stays up first, then the other pages follow
+            ResultLAT = FastestLAT;
+            ResultPWD = FastestPWD;
+            ResultPGS = FastestPGS;
+            ResultRLS = FastestRLS;
+            ResultLevel = Result;
+            ResultPage = PAGE_HEADER_PATCH;
+            PageDeadline = get_ticks() + TICKS_FROM_MS(RESULT_PAGE_MS);
+            CurrentState = STATE_RESULTS;
+#ifdef CONTENTION_BENCH
+            if (BenchPending) {
+                CurrentState = STATE_CONTENTION;
+            }
+#endif
+            break;
+        }
+        
+#ifdef CONTENTION_BENCH
+        case STATE_CONTENTION: {
+            // Games load while they render, so check the chosen timing on a busy RDRAM too.
+            // It runs after the sweep's counters, statistics and times are taken, so none
+            // of its probes count toward them
+            if (!CartProbePresence()) {
+                MatrixViewEnd();
+                CurrentState = STATE_DETECT;
+                break;
+            }
+            
+            uint64_t Now = get_ticks();
+            if (Now < PageDeadline) {
+                // The result page stays up first
+                uint32_t LeftMs = (uint32_t)((PageDeadline - Now) / (TICKS_PER_SECOND / 1000)) + 1;
+                WakeMs = NextPollMs();
+                if (LeftMs < WakeMs) {
+                    WakeMs = LeftMs;
+                }
+                break;
+            }
+            
+            MatrixViewClearText();
+            MatrixViewPrintf("Testing under RDRAM load...\n");
+            MatrixViewPresent(true);
+            RunContentionBench(ResultLAT, ResultPWD, ResultPGS, ResultRLS);
+#ifdef RSP_VERIFY
+            RspVerifyStop();
+#endif
+            if (!CartProbePresence()) {
+                // Pulled during the bench, which then measured open bus
+                MatrixViewEnd();
+                CurrentState = STATE_DETECT;
+                break;
+            }
             
-            CurrentState = STATE_SAFE_REMOVE;
-
+            ExportCartResult(ResultLAT, ResultPWD, ResultPGS, ResultRLS, ResultLevel, NULL);
+            ResultPage = PAGE_HEADER_PATCH;
+            PageDeadline = get_ticks();
+            CurrentState = STATE_RESULTS;
+            break;
+        }
+#endif
+        
+        case STATE_RESULTS: {
+            // Pulling the cart skips the remaining pages
+            if (!CartProbePresence()) {
+                MatrixViewEnd();
+                CurrentState = STATE_DETECT;
+                break;
+            }
+            
+            uint64_t Now = get_ticks();
+            if (Now < PageDeadline) {
+                uint32_t LeftMs = (uint32_t)((PageDeadline - Now) / (TICKS_PER_SECOND / 1000)) + 1;
+                WakeMs = NextPollMs();
+                if (LeftMs < WakeMs) {
+                    WakeMs = LeftMs;
+                }
+                break;
+            }
+            
+            bool Shown = false;
+            while (!Shown && ResultPage < NUM_RESULT_PAGES) {
+                Shown = ShowResultPage((result_page_t)ResultPage++);
+            }
+            if (Shown) {
+                PageDeadline = Now + TICKS_FROM_MS(RESULT_PAGE_MS);
+            } else {
+                CurrentState = STATE_SAFE_REMOVE;
+            }
+            break;
+        }
+        
+#ifdef SOAK_SECONDS
+        case STATE_SOAK: {
+            // One pass per call, so the live counters keep up
+            if (!CartProbePresence()) {
+                MatrixViewEnd();
+                console_clear();
+                printf("Domain 1 Speed Test\n");
+                printf("\nCartridge removed during soak\n");
+                console_render();
+                CurrentState = STATE_DETECT;
+                break;
+            }
+            
+            if (SoakPass()) {
+                // The outcome stays up like a result page
+                FinishSoak();
+                PageDeadline = get_ticks() + TICKS_FROM_MS(RESULT_PAGE_MS);
+                CurrentState = STATE_RESULTS;
+            }
             break;
         }
+#endif
     }
+    
+    return WakeMs;
 }
 
 int main(void) {
+    // Presence polls and result pages are driven by one timer event
+    timer_init();
+    WakeTimer = new_timer(0, TF_DISABLED, WakeCallback);
+    
     while (1) {
-        HandleStateMachine();
-        // Small delay to prevent excessive CPU usage
-        for (volatile int i = 0; i < 10000; i++);
+        uint32_t WakeMs = HandleStateMachine();
+        if (WakeMs == 0) {
+            continue;
+        }
+        
+        // Sleep until the timer interrupt signals the next deadline
+        WakePending = false;
+        start_timer(WakeTimer, TICKS_FROM_MS(WakeMs), TF_ONE_SHOT, WakeCallback);
+        while (!WakePending) {
+        }
     }
     
     return 0;
@@ -0,0 +1,48 @@
+/**
+ * @file export.c
+ * @brief Machine-readable result records over ISViewer
+ */
+
+#include <stdarg.h>
+#include <string.h>
+#include <libdragon.h>
+
+#include "export.h"
+#include "romcheck.h"
+
+// Longest line: the 256-entry LANES table as hex plus its key
+#define EXPORT_LINE_SIZE 1100
+
+static uint32_t RecordCrc;
+
+/**
+ * @brief Send one line and fold it into the record CRC
+ */
+static void ExportWrite(const char * Line) {
+    RecordCrc = RomCrc32Update(RecordCrc, (const uint8_t *)Line, strlen(Line));
+    RecordCrc = RomCrc32Update(RecordCrc, (const uint8_t *)"\n", 1);
+    debugf(EXPORT_PREFIX "%s\n", Line);
+}
+
+void ExportBegin(const char * Type) {
+    char Line[64];
+
+    RecordCrc = ROM_CRC32_INIT;
+    snprintf(Line, sizeof(Line), "BEGIN %d %s", EXPORT_VERSION, Type);
+    ExportWrite(Line);
+}
+
+void ExportLine(const char * Format, ...) {
+    char Line[EXPORT_LINE_SIZE];
+    va_list Args;
+
+    va_start(Args, Format);
+    vsnprintf(Line, sizeof(Line), Format, Args);
+    va_end(Args);
+
+    ExportWrite(Line);
+}
+
+void ExportEnd(void) {
+    debugf(EXPORT_PREFIX "END crc=%08lX\n", (unsigned long)RomCrc32Final(RecordCrc));
+}
@@ -0,0 +1,40 @@
+/**
+ * @file export.h
+ * @brief Machine-readable result records over ISViewer
+ *
+ * A record is a block of lines, each starting with EXPORT_PREFIX so it can be
+ * picked out of a log mixed with other output:
+ *
+ *   #D1ST:BEGIN <version> <type>
+ *   #D1ST:<KEY> <fields...>
+ *   #D1ST:END crc=<CRC32>
+ *
+ * The CRC32 covers the text after the prefix of every line from BEGIN up to
+ * (not including) END, each followed by '\n', so truncated or interleaved
+ * records can be rejected. tools/d1stlog parses these records.
+ */
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdint.h>
+
+#define EXPORT_PREFIX   "#D1ST:"
+#define EXPORT_VERSION  1
+
+/**
+ * @brief Start a record of the given type (e.g. "CART")
+ */
+void ExportBegin(const char * Type);
+
+/**
+ * @brief Write one line of the current record (without prefix or trailing '\n')
+ */
+void ExportLine(const char * Format, ...) __attribute__ ((format(printf, 1, 2)));
+
+/**
+ * @brief Finish the current record with its CRC32
+ */
+void ExportEnd(void);
+
+#endif // EXPORT_H
@@ -0,0 +1,297 @@
+/**
+ * @file matrixview.c
+ * @brief Incremental renderer for the 16x16 speed matrix
+ */
+
+#include <stdarg.h>
+#include <string.h>
+#include <libdragon.h>
+
+#include "matrixview.h"
+#include "profile.h"
+
+// Display buffers tracked (display_init is called with 2, allow up to 3)
+#define MAX_BUFFERS        3
+#define ALL_BUFFERS        ((1 << MAX_BUFFERS) - 1)
+
+// Layout in pixels (8x8 font, 320x240)
+#define TITLE_Y            2
+#define CART_Y             11
+#define COLUMN_HEADER_Y    21
+#define MATRIX_X           8
+#define MATRIX_Y           30
+#define ROW_LABEL_WIDTH    16   // One hex digit plus a gap
+#define CELL_WIDTH         18   // Two hex digits plus a gap
+#define CELL_HEIGHT        8
+#define TEXT_Y             (MATRIX_Y + 16 * CELL_HEIGHT + 3)
+#define TEXT_X             8
+#define TEXT_LINE_HEIGHT   8
+
+static const char * ViewCartName;
+static const uint8_t * ViewMinPWD;
+static const bool * ViewMarks;
+static const uint16_t * ViewLanes;
+static const uint8_t * ViewValues;
+static bool Active = false;
+
+// Per-item dirty bits, one bit per display buffer
+static uint8_t CellDirty[256];
+static uint8_t TextDirty[MATRIX_VIEW_TEXT_LINES];
+static uint8_t FullDirty;
+
+static char TextLines[MATRIX_VIEW_TEXT_LINES][MATRIX_VIEW_TEXT_COLS + 1];
+static int TextLine;
+static int TextColumn;
+
+static surface_t * KnownBuffers[MAX_BUFFERS];
+static volatile uint32_t VblankCount = 0;
+static uint32_t LastPresentVblank = 0xFFFFFFFF;
+static bool VblankHandlerInstalled = false;
+
+static uint32_t ColorBackground;
+static uint32_t ColorText;
+static uint32_t ColorDim;
+static uint32_t ColorMark;
+
+/**
+ * @brief VI interrupt handler: count vblanks to limit presents
+ */
+static void MatrixViewVblank(void) {
+    VblankCount++;
+}
+
+/**
+ * @brief Map a display buffer to its dirty-bit index
+ */
+static int BufferIndex(surface_t * Buffer) {
+    for (int i = 0; i < MAX_BUFFERS; i++) {
+        if (KnownBuffers[i] == Buffer) {
+            return i;
+        }
+    }
+    for (int i = 0; i < MAX_BUFFERS; i++) {
+        if (KnownBuffers[i] == NULL) {
+            KnownBuffers[i] = Buffer;
+            return i;
+        }
+    }
+    // More buffers than expected: forget the others, this one gets a full redraw
+    memset(KnownBuffers, 0, sizeof(KnownBuffers));
+    KnownBuffers[0] = Buffer;
+    FullDirty = ALL_BUFFERS;
+    return 0;
+}
+
+/**
+ * @brief Draw one matrix cell
+ */
+static void DrawCell(surface_t * Buffer, int LAT) {
+    static const char Hex[] = "0123456789ABCDEF";
+    char Text[3];
+    uint32_t Color;
+
+    if (ViewLanes != NULL) {
+        uint16_t Lanes = ViewLanes[LAT];
+        int Count = __builtin_popcount(Lanes);
+        if (Count == 0) {
+            Text[0] = '-';
+            Text[1] = '-';
+            Color = ColorDim;
+        } else if (Count == 1) {
+            Text[0] = 'D';
+            Text[1] = Hex[__builtin_ctz(Lanes)];
+            Color = ColorMark;
+        } else {
+            Text[0] = (Count >= 10) ? '1' : ' ';
+            Text[1] = '0' + Count % 10;
+            Color = ColorText;
+        }
+    } else if (ViewValues != NULL) {
+        uint8_t Value = ViewValues[LAT];
+        if (Value == 0xFF) {
+            Text[0] = '-';
+            Text[1] = '-';
+            Color = ColorDim;
+        } else {
+            Text[0] = (Value > 99) ? '+' : (Value >= 10) ? '0' + Value / 10 : ' ';
+            Text[1] = (Value > 99) ? '+' : '0' + Value % 10;
+            Color = (ViewMarks != NULL && ViewMarks[LAT]) ? ColorMark : ColorText;
+        }
+    } else if (ViewMinPWD[LAT] != 0xFF) {
+        Text[0] = Hex[ViewMinPWD[LAT] >> 4];
+        Text[1] = Hex[ViewMinPWD[LAT] & 0x0F];
+        Color = (ViewMarks != NULL && ViewMarks[LAT]) ? ColorMark : ColorText;
+    } else {
+        Text[0] = '-';
+        Text[1] = '-';
+        Color = ColorDim;
+    }
+    Text[2] = '\0';
+
+    graphics_set_color(Color, ColorBackground);
+    graphics_draw_text(Buffer, MATRIX_X + ROW_LABEL_WIDTH + (LAT & 0x0F) * CELL_WIDTH,
+                       MATRIX_Y + (LAT >> 4) * CELL_HEIGHT, Text);
+}
+
+/**
+ * @brief Draw one line of the text area, clearing what was there
+ */
+static void DrawTextLine(surface_t * Buffer, int Line) {
+    int Y = TEXT_Y + Line * TEXT_LINE_HEIGHT;
+    graphics_draw_box(Buffer, 0, Y, Buffer->width, TEXT_LINE_HEIGHT, ColorBackground);
+    graphics_set_color(ColorText, ColorBackground);
+    graphics_draw_text(Buffer, TEXT_X, Y, TextLines[Line]);
+}
+
+/**
+ * @brief Draw everything that does not change during a sweep
+ */
+static void DrawStatic(surface_t * Buffer) {
+    static const char Hex[] = "0123456789ABCDEF";
+    char Label[2] = { 0, 0 };
+
+    graphics_fill_screen(Buffer, ColorBackground);
+    graphics_set_color(ColorText, ColorBackground);
+    graphics_draw_text(Buffer, MATRIX_X, TITLE_Y, "Domain 1 Speed Test");
+    graphics_draw_text(Buffer, MATRIX_X, CART_Y, "Cartridge:");
+    graphics_draw_text(Buffer, MATRIX_X + 11 * 8, CART_Y, ViewCartName);
+
+    // Column header (LAT low nibble) and row labels (LAT high nibble)
+    graphics_set_color(ColorDim, ColorBackground);
+    for (int i = 0; i < 16; i++) {
+        Label[0] = Hex[i];
+        graphics_draw_text(Buffer, MATRIX_X + ROW_LABEL_WIDTH + i * CELL_WIDTH + 4, COLUMN_HEADER_Y, Label);
+        graphics_draw_text(Buffer, MATRIX_X, MATRIX_Y + i * CELL_HEIGHT, Label);
+    }
+}
+
+void MatrixViewBegin(const char * CartName, const uint8_t * MinPWD, const bool * Marks) {
+    ViewCartName = CartName;
+    ViewMinPWD = MinPWD;
+    ViewMarks = Marks;
+    ViewLanes = NULL;
+    ViewValues = NULL;
+
+    ColorBackground = graphics_make_color(0x00, 0x00, 0x00, 0xFF);
+    ColorText = graphics_make_color(0xFF, 0xFF, 0xFF, 0xFF);
+    ColorDim = graphics_make_color(0x80, 0x80, 0x80, 0xFF);
+    ColorMark = graphics_make_color(0xFF, 0x40, 0x40, 0xFF);
+
+    if (!VblankHandlerInstalled) {
+        register_VI_handler(MatrixViewVblank);
+        VblankHandlerInstalled = true;
+    }
+
+    // Buffer contents are unknown (the console may have drawn into them)
+    memset(KnownBuffers, 0, sizeof(KnownBuffers));
+    memset(CellDirty, ALL_BUFFERS, sizeof(CellDirty));
+    FullDirty = ALL_BUFFERS;
+    MatrixViewClearText();
+    Active = true;
+}
+
+void MatrixViewSetTable(const uint8_t * MinPWD, const bool * Marks) {
+    ViewMinPWD = MinPWD;
+    ViewMarks = Marks;
+    ViewLanes = NULL;
+    ViewValues = NULL;
+    memset(CellDirty, ALL_BUFFERS, sizeof(CellDirty));
+}
+
+void MatrixViewShowLanes(const uint16_t * Lanes) {
+    ViewLanes = Lanes;
+    ViewValues = NULL;
+    memset(CellDirty, ALL_BUFFERS, sizeof(CellDirty));
+}
+
+void MatrixViewShowValues(const uint8_t * Values, const bool * Marks) {
+    ViewValues = Values;
+    ViewMarks = Marks;
+    ViewLanes = NULL;
+    memset(CellDirty, ALL_BUFFERS, sizeof(CellDirty));
+}
+
+void MatrixViewEnd(void) {
+    Active = false;
+}
+
+void MatrixViewMarkCell(int LAT) {
+    CellDirty[LAT & 0xFF] = ALL_BUFFERS;
+}
+
+void MatrixViewClearText(void) {
+    memset(TextLines, 0, sizeof(TextLines));
+    memset(TextDirty, ALL_BUFFERS, sizeof(TextDirty));
+    TextLine = 0;
+    TextColumn = 0;
+}
+
+void MatrixViewPrintf(const char * Format, ...) {
+    char Buffer[128];
+    va_list Args;
+
+    va_start(Args, Format);
+    vsnprintf(Buffer, sizeof(Buffer), Format, Args);
+    va_end(Args);
+
+    for (const char * Char = Buffer; *Char != '\0'; Char++) {
+        if (TextLine >= MATRIX_VIEW_TEXT_LINES) {
+            return;
+        }
+        if (*Char == '\n') {
+            TextLine++;
+            TextColumn = 0;
+            continue;
+        }
+        if (TextColumn < MATRIX_VIEW_TEXT_COLS) {
+            TextLines[TextLine][TextColumn++] = *Char;
+            TextDirty[TextLine] = ALL_BUFFERS;
+        }
+    }
+}
+
+void MatrixViewPresent(bool Wait) {
+    if (!Active) {
+        return;
+    }
+    if (!Wait && LastPresentVblank == VblankCount) {
+        return;
+    }
+
+    PROFILE_BEGIN(Start);
+    surface_t * Buffer = Wait ? display_get() : display_try_get();
+    if (Buffer == NULL) {
+        return;
+    }
+
+    uint8_t Bit = 1 << BufferIndex(Buffer);
+
+    if (FullDirty & Bit) {
+        DrawStatic(Buffer);
+        FullDirty &= ~Bit;
+        // Everything else has to be drawn on top of the cleared buffer
+        for (int LAT = 0; LAT < 256; LAT++) {
+            CellDirty[LAT] |= Bit;
+        }
+        for (int Line = 0; Line < MATRIX_VIEW_TEXT_LINES; Line++) {
+            TextDirty[Line] |= Bit;
+        }
+    }
+
+    for (int LAT = 0; LAT < 256; LAT++) {
+        if (CellDirty[LAT] & Bit) {
+            DrawCell(Buffer, LAT);
+            CellDirty[LAT] &= ~Bit;
+        }
+    }
+    for (int Line = 0; Line < MATRIX_VIEW_TEXT_LINES; Line++) {
+        if (TextDirty[Line] & Bit) {
+            DrawTextLine(Buffer, Line);
+            TextDirty[Line] &= ~Bit;
+        }
+    }
+
+    display_show(Buffer);
+    LastPresentVblank = VblankCount;
+    PROFILE_END(PROFILE_RENDER, Start);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file matrixview.h
+ * @brief Incremental renderer for the 16x16 speed matrix
+ *
+ * Draws straight into the display buffers with the glyph blitter and only
+ * redraws cells and text lines that changed since that buffer was last shown.
+ * Presents are limited to one per vblank, so the UI costs almost nothing while
+ * the sweep is running.
+ */
+
+#ifndef MATRIXVIEW_H
+#define MATRIXVIEW_H
+
+#include <libdragon.h>
+
+// Text area below the matrix
+#define MATRIX_VIEW_TEXT_LINES  9
+#define MATRIX_VIEW_TEXT_COLS   39
+
+/**
+ * @brief Take over the screen and schedule a full redraw
+ * @param CartName Cartridge name shown in the header (must stay valid)
+ * @param MinPWD Minimum PWD per LAT, 0xFF shown as "--" (must stay valid)
+ * @param Marks Cells drawn highlighted, e.g. frontier violations (must stay valid)
+ */
+void MatrixViewBegin(const char * CartName, const uint8_t * MinPWD, const bool * Marks);
+
+/**
+ * @brief Show another per-LAT PWD table (e.g. the PIO frontier) and leave lane mode
+ * @param MinPWD Minimum PWD per LAT, 0xFF shown as "--" (must stay valid)
+ * @param Marks Cells drawn highlighted (must stay valid), may be NULL
+ */
+void MatrixViewSetTable(const uint8_t * MinPWD, const bool * Marks);
+
+/**
+ * @brief Switch the cells between minimum PWD and failing AD lines
+ *
+ * In lane mode a cell shows "Dn" in red when only line ADn failed (a single
+ * weak line), the number of failing lines when several did, and "--" when
+ * nothing failed below the minimum PWD.
+ * @param Lanes Failing AD lines per LAT (must stay valid), NULL for minimum PWD
+ */
+void MatrixViewShowLanes(const uint16_t * Lanes);
+
+/**
+ * @brief Switch the cells to a decimal value per LAT (e.g. a time in tens of ns)
+ *
+ * Values above 99 are shown as "++", 0xFF as "--".
+ * @param Values Value per LAT (must stay valid), NULL for minimum PWD
+ * @param Marks Cells drawn highlighted (must stay valid), may be NULL
+ */
+void MatrixViewShowValues(const uint8_t * Values, const bool * Marks);
+
+/**
+ * @brief Release the screen (e.g. before using the console again)
+ */
+void MatrixViewEnd(void);
+
+/**
+ * @brief Schedule a redraw of one matrix cell
+ */
+void MatrixViewMarkCell(int LAT);
+
+/**
+ * @brief Clear the text area below the matrix
+ */
+void MatrixViewClearText(void);
+
+/**
+ * @brief Append text to the text area; '\n' starts a new line, overflow is dropped
+ */
+void MatrixViewPrintf(const char * Format, ...) __attribute__ ((format(printf, 1, 2)));
+
+/**
+ * @brief Draw pending changes and show them
+ * @param Wait false: skip if a frame was already presented this vblank or no
+ *             buffer is free (changes stay pending); true: always present
+ */
+void MatrixViewPresent(bool Wait);
+
+#endif // MATRIXVIEW_H
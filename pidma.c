@@ -0,0 +1,202 @@
+/**
+ * @file pidma.c
+ * @brief Interrupt-driven PI DMA queue
+ */
+
+#include <libdragon.h>
+
+#include "pidma.h"
+
+// PI registers structure
+typedef struct PI_regs_s {
+    volatile void * ram_address;
+    uint32_t pi_address;
+    uint32_t read_length;
+    uint32_t write_length;
+    uint32_t status;
+} PI_regs_t;
+static volatile PI_regs_t * const PI_regs = (PI_regs_t *)0xA4600000;
+
+#define PI_STATUS_DMA_BUSY  (1 << 0)
+#define PI_STATUS_IO_BUSY   (1 << 1)
+
+typedef struct {
+    void * Ram;         // Destination of a read, source of a write
+    uint32_t PiAddress;
+    uint32_t Len;
+    bool ToCart;        // RDRAM to PI (read_length) instead of PI to RDRAM (write_length)
+    uint32_t Ticks;     // C0 COUNT ticks from programming to completion, set when retired
+} pidma_request_t;
+
+// Ring of queued transfers. Tickets are 1-based sequence numbers: ticket T lives
+// in slot (T - 1) % PIDMA_QUEUE_DEPTH until Completed reaches T.
+static pidma_request_t Queue[PIDMA_QUEUE_DEPTH];
+static volatile uint32_t Submitted = 0;  // Last ticket handed out
+static volatile uint32_t Started = 0;    // Last ticket programmed into the PI
+static volatile uint32_t Completed = 0;  // Last ticket finished
+static uint32_t StartTicks;              // C0 COUNT when the in-flight transfer started
+static bool Initialized = false;
+static pidma_stats_t Stats;
+
+/**
+ * @brief Program the next queued transfer if the PI is free (interrupts disabled)
+ */
+static void StartNext(void) {
+    if (Started != Completed || Started == Submitted) {
+        return;
+    }
+
+    const pidma_request_t * Request = &Queue[Started % PIDMA_QUEUE_DEPTH];
+
+    // A PIO access (e.g. an ISViewer write) may still be on the bus
+    while (PI_regs->status & (PI_STATUS_DMA_BUSY | PI_STATUS_IO_BUSY));
+
+    MEMORY_BARRIER();
+    PI_regs->ram_address = UncachedAddr(Request->Ram);
+    MEMORY_BARRIER();
+    PI_regs->pi_address = Request->PiAddress;
+    MEMORY_BARRIER();
+    StartTicks = C0_COUNT();
+    if (Request->ToCart) {
+        PI_regs->read_length = Request->Len - 1;
+    } else {
+        PI_regs->write_length = Request->Len - 1;
+    }
+    MEMORY_BARRIER();
+
+    Started++;
+}
+
+/**
+ * @brief Retire the in-flight transfer if the PI has finished it (interrupts disabled)
+ *
+ * Safe to call spuriously: it does nothing while the DMA is still running or
+ * when nothing is in flight.
+ */
+static void RetireCompleted(void) {
+    if (Started == Completed) {
+        return;
+    }
+    if (PI_regs->status & PI_STATUS_DMA_BUSY) {
+        return;
+    }
+
+    uint32_t Ticks = C0_COUNT() - StartTicks;
+    Queue[Completed % PIDMA_QUEUE_DEPTH].Ticks = Ticks;
+    Stats.BusyTicks += Ticks;
+    Stats.Transfers++;
+    Completed++;
+
+    StartNext();
+}
+
+/**
+ * @brief PI interrupt handler: retire the finished transfer and chain the next one
+ */
+static void PiDmaInterrupt(void) {
+    RetireCompleted();
+}
+
+void PiDmaInit(void) {
+    if (Initialized) {
+        return;
+    }
+
+    // Drain anything queued before the handler existed
+    PiDmaWaitIdle();
+
+    register_PI_handler(PiDmaInterrupt);
+    set_PI_interrupt(1);
+    Initialized = true;
+}
+
+void PiDmaClose(void) {
+    if (!Initialized) {
+        return;
+    }
+
+    PiDmaWaitIdle();
+
+    set_PI_interrupt(0);
+    unregister_PI_handler(PiDmaInterrupt);
+    Initialized = false;
+}
+
+/**
+ * @brief Queue a transfer in either direction
+ */
+static uint32_t QueueTransfer(void * Ram, uint32_t PiAddress, uint32_t Len, bool ToCart) {
+    assert(Ram != NULL);
+    assert(Len > 0);
+
+    // Wait for a free slot
+    if (Submitted - Completed >= PIDMA_QUEUE_DEPTH) {
+        PiDmaWait(Submitted - PIDMA_QUEUE_DEPTH + 1);
+    }
+
+    disable_interrupts();
+
+    uint32_t Ticket = Submitted + 1;
+    pidma_request_t * Request = &Queue[(Ticket - 1) % PIDMA_QUEUE_DEPTH];
+    Request->Ram = Ram;
+    Request->PiAddress = PiAddress;
+    Request->Len = Len;
+    Request->ToCart = ToCart;
+    Submitted = Ticket;
+
+    StartNext();
+
+    enable_interrupts();
+    return Ticket;
+}
+
+uint32_t PiDmaRead(void * Dest, uint32_t PiAddress, uint32_t Len) {
+    return QueueTransfer(Dest, PiAddress, Len, false);
+}
+
+uint32_t PiDmaWrite(void * Src, uint32_t PiAddress, uint32_t Len) {
+    return QueueTransfer(Src, PiAddress, Len, true);
+}
+
+bool PiDmaIsDone(uint32_t Ticket) {
+    return (int32_t)(Completed - Ticket) >= 0;
+}
+
+void PiDmaWait(uint32_t Ticket) {
+    uint32_t WaitStart = C0_COUNT();
+
+    while (!PiDmaIsDone(Ticket)) {
+        // The interrupt normally retires the transfer; retire it here if the DMA
+        // is done but the interrupt is disabled, not installed yet or was missed
+        if (!(PI_regs->status & PI_STATUS_DMA_BUSY)) {
+            disable_interrupts();
+            RetireCompleted();
+            enable_interrupts();
+        }
+    }
+
+    Stats.WaitTicks += C0_COUNT() - WaitStart;
+}
+
+uint32_t PiDmaTransferTicks(uint32_t Ticket) {
+    assert(PiDmaIsDone(Ticket));
+    return Queue[(Ticket - 1) % PIDMA_QUEUE_DEPTH].Ticks;
+}
+
+void PiDmaWaitIdle(void) {
+    PiDmaWait(Submitted);
+}
+
+void PiDmaGetStats(pidma_stats_t * OutStats) {
+    disable_interrupts();
+    *OutStats = Stats;
+    enable_interrupts();
+}
+
+void PiDmaResetStats(void) {
+    disable_interrupts();
+    Stats.Transfers = 0;
+    Stats.BusyTicks = 0;
+    Stats.WaitTicks = 0;
+    enable_interrupts();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file pidma.h
+ * @brief Interrupt-driven PI DMA queue
+ *
+ * Transfers are queued and chained from the PI interrupt, so the CPU can work
+ * on a completed buffer while the next transfer is on the bus.
+ */
+
+#ifndef PIDMA_H
+#define PIDMA_H
+
+#include <libdragon.h>
+
+// Maximum number of queued (not yet completed) transfers
+#define PIDMA_QUEUE_DEPTH 8
+
+/**
+ * @brief Transfer statistics used to report how much PI time was overlapped
+ */
+typedef struct {
+    uint32_t Transfers;   // Completed transfers
+    uint64_t BusyTicks;   // C0 COUNT ticks the PI spent on transfers
+    uint64_t WaitTicks;   // C0 COUNT ticks the CPU spent blocked in PiDmaWait
+} pidma_stats_t;
+
+/**
+ * @brief Install the PI interrupt handler and enable the PI interrupt
+ */
+void PiDmaInit(void);
+
+/**
+ * @brief Wait for outstanding transfers and remove the PI interrupt handler
+ */
+void PiDmaClose(void);
+
+/**
+ * @brief Queue a PI to RDRAM transfer
+ *
+ * The destination must stay valid until the transfer completes. Cache
+ * maintenance of the destination is left to the caller.
+ *
+ * @param Dest RDRAM destination (8-byte aligned)
+ * @param PiAddress Physical PI bus address to read from
+ * @param Len Number of bytes to transfer
+ * @return Ticket to pass to PiDmaWait / PiDmaIsDone
+ */
+uint32_t PiDmaRead(void * Dest, uint32_t PiAddress, uint32_t Len);
+
+/**
+ * @brief Queue an RDRAM to PI transfer (a write to the cart)
+ *
+ * Shares the queue, the tickets and the statistics with PiDmaRead. The
+ * source must stay valid until the transfer completes and must not have
+ * dirty lines in the data cache.
+ *
+ * @param Src RDRAM source (8-byte aligned)
+ * @param PiAddress Physical PI bus address to write to
+ * @param Len Number of bytes to transfer
+ * @return Ticket to pass to PiDmaWait / PiDmaIsDone
+ */
+uint32_t PiDmaWrite(void * Src, uint32_t PiAddress, uint32_t Len);
+
+/**
+ * @brief Check whether a queued transfer has completed
+ */
+bool PiDmaIsDone(uint32_t Ticket);
+
+/**
+ * @brief Block until a queued transfer has completed
+ *
+ * Completion normally comes from the PI interrupt; while waiting, the PI status
+ * register is also checked so this works with interrupts disabled or before
+ * PiDmaInit.
+ */
+void PiDmaWait(uint32_t Ticket);
+
+/**
+ * @brief C0 COUNT ticks a completed transfer took from being programmed to its completion
+ *
+ * Includes the time to notice the completion (interrupt entry or polling).
+ * Valid until PIDMA_QUEUE_DEPTH more transfers have been queued.
+ */
+uint32_t PiDmaTransferTicks(uint32_t Ticket);
+
+/**
+ * @brief Block until every queued transfer has completed
+ */
+void PiDmaWaitIdle(void);
+
+/**
+ * @brief Get transfer statistics since the last PiDmaResetStats
+ */
+void PiDmaGetStats(pidma_stats_t * OutStats);
+
+/**
+ * @brief Reset transfer statistics
+ */
+void PiDmaResetStats(void);
+
+#endif // PIDMA_H
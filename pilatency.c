@@ -0,0 +1,234 @@
+/**
+ * @file pilatency.c
+ * @brief Per-cell DMA completion latency histograms
+ */
+
+#include <string.h>
+#include <libdragon.h>
+
+#include "pilatency.h"
+#include "pimodel.h"
+
+#ifdef DMA_LATENCY
+
+// One RCP cycle is 16 ns
+#define NS_PER_RCP_CYCLE  (1000000000 / PI_MODEL_RCP_HZ)
+
+// LATs needed before a verdict, and the spread of model costs needed for a slope
+#define MIN_VERDICT_CELLS 4
+#define MIN_SLOPE_SPREAD  NS_PER_RCP_CYCLE
+
+static const char * VerdictNames[] = {
+    "not enough data",
+    "follows the timing registers",
+    "adds its own wait states",
+    "ignores the timing registers"
+};
+
+// Fixed buffer in RDRAM, no allocation while probing
+static pi_latency_cell_t Cells[PI_LATENCY_MAX_CELLS];
+static int NumCells = 0;
+static uint32_t DroppedSamples = 0;
+static int32_t OverheadCycles = PI_MODEL_SETUP_CYCLES;
+
+/**
+ * @brief Convert C0 COUNT ticks to RCP cycles
+ */
+static int32_t TicksToRcpCycles(uint32_t Ticks) {
+    return (int32_t)((uint64_t)Ticks * PI_MODEL_RCP_HZ / TICKS_PER_SECOND);
+}
+
+/**
+ * @brief Model bus time of one DMA without the fixed setup cost, counting the pages it actually touches
+ */
+static int32_t ModelBusCycles(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint32_t Offset, uint32_t Len) {
+    uint32_t Shift = (PGS & 0x0F) + 2;
+    uint32_t PageSize = 1u << Shift;
+    uint32_t AlignedPages = (Len + PageSize - 1) / PageSize;
+    uint32_t Pages = ((Offset + Len - 1) >> Shift) - (Offset >> Shift) + 1;
+
+    return (int32_t)(PiModelCycles(LAT, PWD, PGS, RLS, Len) - PI_MODEL_SETUP_CYCLES +
+                     (Pages - AlignedPages) * ((uint32_t)LAT + 1));
+}
+
+/**
+ * @brief Deviation in 1/16 cycle rounded to whole cycles, as a histogram bucket
+ */
+static int DeviationBucket(int32_t Deviation16) {
+    int32_t Cycles = (Deviation16 >= 0) ? (Deviation16 + 8) / 16 : -((-Deviation16 + 8) / 16);
+    int32_t Bucket = Cycles + PI_LATENCY_ZERO_BUCKET;
+    if (Bucket < 0) {
+        return 0;
+    }
+    if (Bucket >= PI_LATENCY_BUCKETS) {
+        return PI_LATENCY_BUCKETS - 1;
+    }
+    return (int)Bucket;
+}
+
+void PiLatencyCalibrate(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS,
+                        uint32_t ShortLen, uint32_t ShortTicks, uint32_t LongLen, uint32_t LongTicks) {
+    assert(LongLen > ShortLen);
+
+    NumCells = 0;
+    DroppedSamples = 0;
+
+    // Residual = overhead + extra per halfword; two lengths separate the two
+    int32_t ShortHalfwords = (int32_t)((ShortLen + 1) / 2);
+    int32_t LongHalfwords = (int32_t)((LongLen + 1) / 2);
+    int32_t ShortResidual = TicksToRcpCycles(ShortTicks) - ModelBusCycles(LAT, PWD, PGS, RLS, 0, ShortLen);
+    int32_t LongResidual = TicksToRcpCycles(LongTicks) - ModelBusCycles(LAT, PWD, PGS, RLS, 0, LongLen);
+    int32_t Extra16 = (LongResidual - ShortResidual) * 16 / (LongHalfwords - ShortHalfwords);
+
+    OverheadCycles = ShortResidual - Extra16 * ShortHalfwords / 16;
+    if (OverheadCycles < 0) {
+        OverheadCycles = 0;
+    }
+
+    debugf("DMA latency: %ld RCP cycles per DMA, %ld/16 cycles per halfword off the model at LAT=0x%02X PWD=0x%02X\n",
+           (long)OverheadCycles, (long)Extra16, LAT, PWD);
+}
+
+void PiLatencyRecord(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS,
+                     uint32_t Offset, uint32_t Len, uint32_t Ticks) {
+    // Probes of one cell are usually back to back, so search from the newest
+    pi_latency_cell_t * Cell = NULL;
+    for (int i = NumCells - 1; i >= 0; i--) {
+        if (Cells[i].LAT == LAT && Cells[i].PWD == PWD && Cells[i].PGS == PGS && Cells[i].RLS == RLS) {
+            Cell = &Cells[i];
+            break;
+        }
+    }
+    if (Cell == NULL) {
+        if (NumCells >= PI_LATENCY_MAX_CELLS) {
+            DroppedSamples++;
+            return;
+        }
+        Cell = &Cells[NumCells++];
+        memset(Cell, 0, sizeof(*Cell));
+        Cell->LAT = LAT;
+        Cell->PWD = PWD;
+        Cell->PGS = PGS;
+        Cell->RLS = RLS;
+    }
+
+    int32_t Halfwords = (int32_t)((Len + 1) / 2);
+    int32_t BusCycles = TicksToRcpCycles(Ticks) - OverheadCycles;
+    int32_t ModelCycles = ModelBusCycles(LAT, PWD, PGS, RLS, Offset, Len);
+    int32_t Deviation16 = (BusCycles - ModelCycles) * 16 / Halfwords;
+
+    // Delays only ever add time, so the fastest DMA is the best estimate
+    if (Cell->Count == 0 || Deviation16 < Cell->BestDeviation16) {
+        Cell->BestDeviation16 = Deviation16;
+        Cell->BestNs = (BusCycles > 0) ? (uint32_t)(BusCycles * NS_PER_RCP_CYCLE / Halfwords) : 0;
+        Cell->ModelNs = (uint32_t)(ModelCycles * NS_PER_RCP_CYCLE / Halfwords);
+    }
+    Cell->Count++;
+    Cell->Buckets[DeviationBucket(Deviation16)]++;
+}
+
+const pi_latency_cell_t * PiLatencyFind(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    for (int i = NumCells - 1; i >= 0; i--) {
+        if (Cells[i].LAT == LAT && Cells[i].PWD == PWD && Cells[i].PGS == PGS && Cells[i].RLS == RLS) {
+            return &Cells[i];
+        }
+    }
+    return NULL;
+}
+
+void PiLatencySummarize(const uint8_t * PWDForLAT, uint8_t PGS, uint8_t RLS,
+                        uint16_t * OutNs, bool * OutMismatch, pi_latency_summary_t * OutSummary) {
+    int32_t Deviations[256];
+    float SumModel = 0.0f, SumMeasured = 0.0f, SumModelSq = 0.0f, SumProduct = 0.0f;
+    int Timed = 0;
+
+    memset(OutSummary, 0, sizeof(*OutSummary));
+    for (int LAT = 0; LAT < 256; LAT++) {
+        OutNs[LAT] = 0xFFFF;
+        OutMismatch[LAT] = false;
+
+        const pi_latency_cell_t * Cell = (PWDForLAT[LAT] != 0xFF) ?
+                                         PiLatencyFind((uint8_t)LAT, PWDForLAT[LAT], PGS, RLS) : NULL;
+        if (Cell == NULL) {
+            continue;
+        }
+
+        OutNs[LAT] = (Cell->BestNs < 0xFFFF) ? (uint16_t)Cell->BestNs : 0xFFFE;
+        OutMismatch[LAT] = (Cell->BestDeviation16 > PI_LATENCY_TOLERANCE16 ||
+                            Cell->BestDeviation16 < -PI_LATENCY_TOLERANCE16);
+        if (OutMismatch[LAT]) {
+            OutSummary->Mismatched++;
+        }
+
+        // Insertion sort for the median
+        int i = Timed;
+        while (i > 0 && Deviations[i - 1] > Cell->BestDeviation16) {
+            Deviations[i] = Deviations[i - 1];
+            i--;
+        }
+        Deviations[i] = Cell->BestDeviation16;
+
+        SumModel += (float)Cell->ModelNs;
+        SumMeasured += (float)Cell->BestNs;
+        SumModelSq += (float)Cell->ModelNs * (float)Cell->ModelNs;
+        SumProduct += (float)Cell->ModelNs * (float)Cell->BestNs;
+        Timed++;
+    }
+
+    OutSummary->Cells = Timed;
+    if (Timed < MIN_VERDICT_CELLS) {
+        OutSummary->Verdict = PI_LATENCY_UNKNOWN;
+        return;
+    }
+    OutSummary->Offset16 = Deviations[Timed / 2];
+
+    // Least-squares slope of measured against modelled time, when the cells differ enough
+    float Mean = SumModel / Timed;
+    float Variance = SumModelSq / Timed - Mean * Mean;
+    bool SlopeKnown = (Variance >= (float)(MIN_SLOPE_SPREAD * MIN_SLOPE_SPREAD));
+    OutSummary->SlopePercent = 100;
+    if (SlopeKnown) {
+        float Covariance = SumProduct / Timed - Mean * (SumMeasured / Timed);
+        OutSummary->SlopePercent = (int32_t)(Covariance / Variance * 100.0f);
+    }
+
+    if (SlopeKnown && OutSummary->SlopePercent < 50) {
+        OutSummary->Verdict = PI_LATENCY_IGNORES;
+    } else if (OutSummary->Offset16 <= PI_LATENCY_TOLERANCE16 && OutSummary->Offset16 >= -PI_LATENCY_TOLERANCE16) {
+        OutSummary->Verdict = PI_LATENCY_FOLLOWS;
+    } else {
+        OutSummary->Verdict = PI_LATENCY_OFFSET;
+    }
+}
+
+uint32_t PiLatencyOverheadCycles(void) {
+    return (uint32_t)OverheadCycles;
+}
+
+const char * PiLatencyVerdictName(pi_latency_verdict_t Verdict) {
+    return (Verdict <= PI_LATENCY_IGNORES) ? VerdictNames[Verdict] : "unknown";
+}
+
+void PiLatencyReport(void) {
+    debugf("DMA latency: %d cell(s), %lu DMA(s) dropped, overhead %ld RCP cycles per DMA\n",
+           NumCells, (unsigned long)DroppedSamples, (long)OverheadCycles);
+    debugf("DMA latency: LAT, PWD, PGS, RLS, count, best ns/halfword, model ns/halfword, deviation/16\n");
+
+    for (int i = 0; i < NumCells; i++) {
+        const pi_latency_cell_t * Cell = &Cells[i];
+        debugf("%02X, %02X, %X, %X, %lu, %lu, %lu, %ld\n", Cell->LAT, Cell->PWD, Cell->PGS, Cell->RLS,
+               (unsigned long)Cell->Count, (unsigned long)Cell->BestNs, (unsigned long)Cell->ModelNs,
+               (long)Cell->BestDeviation16);
+
+        // Histogram: "cycles off the model:count" for non-empty buckets
+        debugf("  histogram:");
+        for (int Bucket = 0; Bucket < PI_LATENCY_BUCKETS; Bucket++) {
+            if (Cell->Buckets[Bucket] != 0) {
+                debugf(" %+d:%lu", Bucket - PI_LATENCY_ZERO_BUCKET, (unsigned long)Cell->Buckets[Bucket]);
+            }
+        }
+        debugf("\n");
+    }
+}
+
+#endif // DMA_LATENCY
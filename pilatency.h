@@ -0,0 +1,120 @@
+/**
+ * @file pilatency.h
+ * @brief Per-cell DMA completion latency histograms
+ *
+ * Enabled with -DDMA_LATENCY. Each probe DMA is timed with C0 COUNT from the
+ * moment it is programmed until it completes, and compared with the PI timing
+ * model for its LAT/PWD/PGS/RLS cell. The fixed cost of every DMA (register
+ * setup, noticing the completion) is measured once per cart at the slowest
+ * timing, so what is left is bus time per halfword. A cart whose timing
+ * follows the registers matches the model in every cell, extra wait states
+ * show up as a constant offset, and a cart that ignores the registers barely
+ * changes from cell to cell.
+ */
+
+#ifndef PILATENCY_H
+#define PILATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Can be defined via Makefile: N64_CFLAGS += -DDMA_LATENCY
+//#define DMA_LATENCY
+
+// Cells with their own histogram; probes of further cells are dropped
+#define PI_LATENCY_MAX_CELLS   1024
+
+// Histogram buckets: deviation from the model in whole RCP cycles per halfword,
+// bucket 0 is -2 or less, bucket 2 matches the model, bucket 7 is +5 or more
+#define PI_LATENCY_BUCKETS     8
+#define PI_LATENCY_ZERO_BUCKET 2
+
+// Deviation (in 1/16 RCP cycle per halfword) still counted as matching the model.
+// Wait states come in whole cycles, so half a cycle separates them from jitter.
+#define PI_LATENCY_TOLERANCE16 8
+
+// What the timed cells say about the cart
+typedef enum {
+    PI_LATENCY_UNKNOWN = 0,    // Too few cells timed
+    PI_LATENCY_FOLLOWS,        // Matches the programmed timing
+    PI_LATENCY_OFFSET,         // Follows the programmed timing plus a constant per halfword
+    PI_LATENCY_IGNORES         // Barely changes with the programmed timing
+} pi_latency_verdict_t;
+
+// One LAT/PWD/PGS/RLS cell
+typedef struct {
+    uint8_t LAT;
+    uint8_t PWD;
+    uint8_t PGS;
+    uint8_t RLS;
+    uint32_t Count;            // DMAs timed
+    uint32_t BestNs;           // Fastest measured bus time per halfword
+    uint32_t ModelNs;          // Model bus time per halfword for the same DMA
+    int32_t BestDeviation16;   // Fastest DMA minus model, in 1/16 RCP cycle per halfword
+    uint32_t Buckets[PI_LATENCY_BUCKETS];
+} pi_latency_cell_t;
+
+// Fit over one cell per LAT (e.g. the frontier)
+typedef struct {
+    pi_latency_verdict_t Verdict;
+    int Cells;                 // LATs with a timed cell
+    int Mismatched;            // Cells off the model by more than PI_LATENCY_TOLERANCE16
+    int32_t Offset16;          // Median deviation, in 1/16 RCP cycle per halfword
+    int32_t SlopePercent;      // Measured change per modelled change, 100 = follows the timing
+} pi_latency_summary_t;
+
+#ifdef DMA_LATENCY
+
+/**
+ * @brief Forget all cells and derive the fixed per-DMA cost from two DMAs of different length
+ *
+ * Both DMAs start on a page boundary and use the same timing, normally the
+ * slowest one. Their difference to the model gives the cost every DMA pays
+ * regardless of length, and the extra time per halfword at this timing.
+ * @param ShortTicks Fastest of several ShortLen-byte DMAs, in C0 COUNT ticks
+ * @param LongTicks Fastest of several LongLen-byte DMAs, in C0 COUNT ticks
+ */
+void PiLatencyCalibrate(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS,
+                        uint32_t ShortLen, uint32_t ShortTicks, uint32_t LongLen, uint32_t LongTicks);
+
+/**
+ * @brief Add one timed DMA to the histogram of its cell
+ * @param Offset PI address or ROM offset of the DMA (for page crossings)
+ * @param Ticks PiDmaTransferTicks of the DMA
+ */
+void PiLatencyRecord(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS,
+                     uint32_t Offset, uint32_t Len, uint32_t Ticks);
+
+/**
+ * @brief Look up a cell
+ * @return NULL if no DMA was timed with this timing
+ */
+const pi_latency_cell_t * PiLatencyFind(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS);
+
+/**
+ * @brief Summarize the cell chosen for each LAT, e.g. the minimum working PWD
+ * @param PWDForLAT PWD per LAT, 0xFF for none
+ * @param OutNs Bus time per halfword of each LAT's cell, 0xFFFF if not timed
+ * @param OutMismatch Set for cells off the model by more than PI_LATENCY_TOLERANCE16
+ */
+void PiLatencySummarize(const uint8_t * PWDForLAT, uint8_t PGS, uint8_t RLS,
+                        uint16_t * OutNs, bool * OutMismatch, pi_latency_summary_t * OutSummary);
+
+/**
+ * @brief Fixed per-DMA cost found by PiLatencyCalibrate, in RCP cycles
+ */
+uint32_t PiLatencyOverheadCycles(void);
+
+/**
+ * @brief Short description of a verdict
+ */
+const char * PiLatencyVerdictName(pi_latency_verdict_t Verdict);
+
+/**
+ * @brief Send every cell with its histogram over ISViewer
+ */
+void PiLatencyReport(void);
+
+#endif // DMA_LATENCY
+
+#endif // PILATENCY_H
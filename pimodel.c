@@ -0,0 +1,28 @@
+/**
+ * @file pimodel.c
+ * @brief PI bus timing cost model
+ */
+
+#include "pimodel.h"
+
+uint32_t PiModelCycles(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint32_t Len) {
+    uint32_t PageSize = 1u << ((PGS & 0x0F) + 2);
+    uint32_t Pages = (Len + PageSize - 1) / PageSize;
+    uint32_t Halfwords = (Len + 1) / 2;
+
+    return PI_MODEL_SETUP_CYCLES +
+           Pages * ((uint32_t)LAT + 1) +
+           Halfwords * ((uint32_t)PWD + 1 + (uint32_t)(RLS & 0x03) + 1);
+}
+
+uint32_t PiModelKBPerSec(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint32_t Len) {
+    uint32_t Cycles = PiModelCycles(LAT, PWD, PGS, RLS, Len);
+    return (uint32_t)((uint64_t)Len * PI_MODEL_RCP_HZ / Cycles / 1000);
+}
+
+uint32_t PiModelPercentOfRetail(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint32_t Len) {
+    uint32_t Cycles = PiModelCycles(LAT, PWD, PGS, RLS, Len);
+    uint32_t RetailCycles = PiModelCycles(PI_MODEL_RETAIL_LAT, PI_MODEL_RETAIL_PWD,
+                                          PI_MODEL_RETAIL_PGS, PI_MODEL_RETAIL_RLS, Len);
+    return (uint32_t)((uint64_t)RetailCycles * 100 / Cycles);
+}
@@ -0,0 +1,45 @@
+/**
+ * @file pimodel.h
+ * @brief PI bus timing cost model
+ *
+ * A PI transfer is split into pages of 2^(PGS+2) bytes. Each page starts with a
+ * latency phase of LAT+1 RCP cycles, then every halfword takes a read pulse of
+ * PWD+1 cycles and a release of RLS+1 cycles. Each DMA also pays a fixed setup
+ * cost.
+ */
+
+#ifndef PIMODEL_H
+#define PIMODEL_H
+
+#include <stdint.h>
+
+// RCP clock the PI timings are counted in
+#define PI_MODEL_RCP_HZ        62500000
+
+// Fixed per-DMA cost (register setup and completion) in RCP cycles
+#define PI_MODEL_SETUP_CYCLES  64
+
+// Retail cartridge timing (header word 0x80371240), the reference for speed levels
+#define PI_MODEL_RETAIL_LAT    0x40
+#define PI_MODEL_RETAIL_PWD    0x12
+#define PI_MODEL_RETAIL_PGS    0x07
+#define PI_MODEL_RETAIL_RLS    0x03
+
+/**
+ * @brief Predict the RCP cycles one DMA of Len bytes takes (page-aligned start)
+ */
+uint32_t PiModelCycles(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint32_t Len);
+
+/**
+ * @brief Predict the sustained throughput of back-to-back DMAs of Len bytes
+ * @return Throughput in KB/s (1 KB = 1000 bytes)
+ */
+uint32_t PiModelKBPerSec(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint32_t Len);
+
+/**
+ * @brief Predicted throughput relative to the retail timing
+ * @return Percentage of retail throughput (100 = as fast as retail)
+ */
+uint32_t PiModelPercentOfRetail(uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint32_t Len);
+
+#endif // PIMODEL_H
@@ -0,0 +1,276 @@
+/**
+ * @file pisweep.c
+ * @brief LAT/PWD search strategies and presence detection behind a PI bus interface
+ */
+
+#include <stddef.h>
+
+#include "pisweep.h"
+
+static const char * StrategyNames[NUM_PI_SWEEP_STRATEGIES] = {
+    "exhaustive",
+    "frontier",
+    "bisect"
+};
+
+uint8_t PiSweepFindMinPWD(const pi_bus_t * Bus, uint8_t LAT, uint8_t Bound, uint8_t PGS, uint8_t RLS,
+                          bool * OutViolation, uint16_t * OutLanes) {
+    int Pass;        // Known working PWD
+    int Fail = -1;   // Known failing PWD below Pass (-1 when PWD 0 is still untested)
+    uint16_t Lanes = 0;
+    uint16_t FailLanes = 0;
+
+    *OutViolation = false;
+    *OutLanes = 0;
+    if (Bus->Probe(Bus->Context, LAT, Bound, PGS, RLS, &Lanes)) {
+        Pass = Bound;
+
+        // Gallop downward until a probe fails
+        int Step = 1;
+        while (Pass - Step > Fail) {
+            int Next = Pass - Step;
+            if (!Bus->Probe(Bus->Context, LAT, (uint8_t)Next, PGS, RLS, &Lanes)) {
+                Fail = Next;
+                FailLanes = Lanes;
+                break;
+            }
+            Pass = Next;
+            Step *= 2;
+        }
+    } else {
+        if (Bound == PI_SWEEP_NONE) {
+            // Nothing works at this LAT
+            return PI_SWEEP_NONE;
+        }
+
+        // Minimum PWD went up as LAT went up - search above the bound
+        *OutViolation = true;
+        FailLanes = Lanes;
+        if (!Bus->Probe(Bus->Context, LAT, 0xFF, PGS, RLS, &Lanes)) {
+            return PI_SWEEP_NONE;
+        }
+        Pass = 0xFF;
+        Fail = Bound;
+    }
+
+    // Bisect between the last failing and the last working PWD
+    while (Pass - Fail > 1) {
+        int Mid = Fail + (Pass - Fail) / 2;
+        if (Bus->Probe(Bus->Context, LAT, (uint8_t)Mid, PGS, RLS, &Lanes)) {
+            Pass = Mid;
+        } else {
+            Fail = Mid;
+            FailLanes = Lanes;
+        }
+    }
+
+    *OutLanes = FailLanes;
+    return (uint8_t)Pass;
+}
+
+/**
+ * @brief Probe every PWD at one LAT
+ */
+static uint8_t FindMinPWDExhaustive(const pi_bus_t * Bus, uint8_t LAT, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    uint8_t MinPWD = PI_SWEEP_NONE;
+    uint16_t Lanes = 0;
+
+    *OutLanes = 0;
+    for (int PWD = 0; PWD < 256; PWD++) {
+        if (Bus->Probe(Bus->Context, LAT, (uint8_t)PWD, PGS, RLS, &Lanes)) {
+            if (MinPWD == PI_SWEEP_NONE) {
+                MinPWD = (uint8_t)PWD;
+            }
+        } else if (MinPWD == PI_SWEEP_NONE) {
+            // Fastest failing PWD so far below the first working one
+            *OutLanes = Lanes;
+        }
+    }
+    return MinPWD;
+}
+
+/**
+ * @brief Bisect the whole PWD range at one LAT
+ */
+static uint8_t FindMinPWDBisect(const pi_bus_t * Bus, uint8_t LAT, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    int Pass = 0xFF;
+    int Fail = -1;
+    uint16_t Lanes = 0;
+
+    *OutLanes = 0;
+    if (!Bus->Probe(Bus->Context, LAT, 0xFF, PGS, RLS, &Lanes)) {
+        return PI_SWEEP_NONE;
+    }
+    while (Pass - Fail > 1) {
+        int Mid = Fail + (Pass - Fail) / 2;
+        if (Bus->Probe(Bus->Context, LAT, (uint8_t)Mid, PGS, RLS, &Lanes)) {
+            Pass = Mid;
+        } else {
+            Fail = Mid;
+            *OutLanes = Lanes;
+        }
+    }
+    return (uint8_t)Pass;
+}
+
+/**
+ * @brief After a full matrix row of identical raised results, fill the rest of the table with it
+ * @return true if the table was filled and the walk is done
+ */
+static bool FillIfRowSettled(uint8_t * PWDForLAT, int LAT, pi_sweep_progress_t Progress, void * ProgressContext) {
+    if ((LAT % 16) != 15 || LAT == 255) {
+        return false;
+    }
+
+    int RowStart = LAT - 15;
+    if (PWDForLAT[RowStart] == PI_SWEEP_NONE) {
+        return false;
+    }
+    for (int i = 1; i < 16; i++) {
+        if (PWDForLAT[RowStart + i] != PWDForLAT[RowStart]) {
+            return false;
+        }
+    }
+    for (int RemainingLAT = LAT + 1; RemainingLAT < 256; RemainingLAT++) {
+        PWDForLAT[RemainingLAT] = PWDForLAT[RowStart];
+        if (Progress != NULL) {
+            Progress(ProgressContext, RemainingLAT);
+        }
+    }
+    return true;
+}
+
+int PiSweepRun(const pi_bus_t * Bus, pi_sweep_strategy_t Strategy, uint8_t PGS, uint8_t RLS,
+               uint8_t * MinPWDForLAT, bool * Violations, uint16_t * FailLanes,
+               pi_sweep_progress_t Progress, void * ProgressContext) {
+    int ViolationCount = 0;
+
+    for (int LAT = 0; LAT < 256; LAT++) {
+        MinPWDForLAT[LAT] = PI_SWEEP_NONE;
+        if (Violations != NULL) {
+            Violations[LAT] = false;
+        }
+        if (FailLanes != NULL) {
+            FailLanes[LAT] = 0;
+        }
+    }
+
+    for (int LAT = 0; LAT < 256; LAT++) {
+        uint8_t Bound = (LAT > 0) ? MinPWDForLAT[LAT - 1] : PI_SWEEP_NONE;
+        bool Violation;
+        uint16_t Lanes;
+
+        if (Strategy == PI_SWEEP_FRONTIER) {
+            MinPWDForLAT[LAT] = PiSweepFindMinPWD(Bus, (uint8_t)LAT, Bound, PGS, RLS, &Violation, &Lanes);
+        } else {
+            if (Strategy == PI_SWEEP_EXHAUSTIVE) {
+                MinPWDForLAT[LAT] = FindMinPWDExhaustive(Bus, (uint8_t)LAT, PGS, RLS, &Lanes);
+            } else {
+                MinPWDForLAT[LAT] = FindMinPWDBisect(Bus, (uint8_t)LAT, PGS, RLS, &Lanes);
+            }
+            Violation = (Bound != PI_SWEEP_NONE && MinPWDForLAT[LAT] > Bound);
+        }
+
+        if (Violation) {
+            ViolationCount++;
+        }
+        if (Violations != NULL) {
+            Violations[LAT] = Violation;
+        }
+        if (FailLanes != NULL) {
+            FailLanes[LAT] = Lanes;
+        }
+        if (Progress != NULL) {
+            Progress(ProgressContext, LAT);
+        }
+    }
+
+    return ViolationCount;
+}
+
+uint8_t PiSweepRaisePWD(const pi_bus_t * Bus, uint8_t LAT, uint8_t Floor, uint8_t PGS, uint8_t RLS) {
+    uint16_t Lanes = 0;
+
+    if (Floor == PI_SWEEP_NONE) {
+        return PI_SWEEP_NONE;
+    }
+    if (Bus->Probe(Bus->Context, LAT, Floor, PGS, RLS, &Lanes)) {
+        return Floor;
+    }
+
+    // Gallop upward until a probe passes
+    int Fail = Floor;   // Known failing PWD
+    int Pass = -1;      // Known working PWD above Fail
+    int Step = 1;
+    while (Pass < 0) {
+        int Next = (Fail + Step < 0xFF) ? Fail + Step : 0xFF;
+        if (Bus->Probe(Bus->Context, LAT, (uint8_t)Next, PGS, RLS, &Lanes)) {
+            Pass = Next;
+        } else if (Next == 0xFF) {
+            return PI_SWEEP_NONE;
+        } else {
+            Fail = Next;
+            Step *= 2;
+        }
+    }
+
+    // Bisect between the last failing and the last working PWD
+    while (Pass - Fail > 1) {
+        int Mid = Fail + (Pass - Fail) / 2;
+        if (Bus->Probe(Bus->Context, LAT, (uint8_t)Mid, PGS, RLS, &Lanes)) {
+            Pass = Mid;
+        } else {
+            Fail = Mid;
+        }
+    }
+    return (uint8_t)Pass;
+}
+
+int PiSweepRaise(const pi_bus_t * Bus, uint8_t PGS, uint8_t RLS, const uint8_t * Floor,
+                 uint8_t * PWDForLAT, pi_sweep_progress_t Progress, void * ProgressContext) {
+    int RaisedCount = 0;
+
+    for (int LAT = 0; LAT < 256; LAT++) {
+        PWDForLAT[LAT] = PI_SWEEP_NONE;
+    }
+
+    for (int LAT = 0; LAT < 256; LAT++) {
+        PWDForLAT[LAT] = PiSweepRaisePWD(Bus, (uint8_t)LAT, Floor[LAT], PGS, RLS);
+        if (PWDForLAT[LAT] != Floor[LAT]) {
+            RaisedCount++;
+        }
+        if (Progress != NULL) {
+            Progress(ProgressContext, LAT);
+        }
+        if (FillIfRowSettled(PWDForLAT, LAT, Progress, ProgressContext)) {
+            break;
+        }
+    }
+
+    return RaisedCount;
+}
+
+bool PiSweepWordIsOpenBus(uint32_t Address, uint32_t Word) {
+    uint16_t Lower16Bits = (uint16_t)(Address & 0xFFFF);
+    return (uint16_t)(Word & 0xFFFF) == Lower16Bits || (uint16_t)(Word >> 16) == Lower16Bits;
+}
+
+bool PiSweepDetectPresence(const pi_bus_t * Bus, uint32_t BaseAddress) {
+    // Only words 0 and 2 are checked, each with its own read: an empty slot
+    // repeats the address a burst started at, which can pass for data later on
+    for (int i = 0; i < 4; i += 2) {
+        uint32_t Word;
+        Bus->ReadWords(Bus->Context, i * 4, &Word, 1);
+        if (!PiSweepWordIsOpenBus(BaseAddress + i * 4, Word)) {
+            // Doesn't match open bus - something answered
+            return true;
+        }
+    }
+
+    // All checked words matched the open bus pattern
+    return false;
+}
+
+const char * PiSweepStrategyName(pi_sweep_strategy_t Strategy) {
+    return (Strategy < NUM_PI_SWEEP_STRATEGIES) ? StrategyNames[Strategy] : "unknown";
+}
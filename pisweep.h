@@ -0,0 +1,128 @@
+/**
+ * @file pisweep.h
+ * @brief LAT/PWD search strategies and presence detection behind a PI bus interface
+ *
+ * Nothing here touches the hardware: every read goes through a pi_bus_t. The
+ * ROM passes buses that program the PI and read the cartridge, tools/pisim
+ * passes a simulated peripheral so strategies can be compared on the host.
+ */
+
+#ifndef PISWEEP_H
+#define PISWEEP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Value of a MinPWDForLAT entry when no PWD works at that LAT
+#define PI_SWEEP_NONE  0xFF
+
+/**
+ * @brief Read access to one PI domain
+ */
+typedef struct {
+    /**
+     * Program the timing, read the sample blocks and compare them with the
+     * reference. On a failure, *OutLanes is set to the AD lines that were wrong.
+     */
+    bool (*Probe)(void * Context, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes);
+    /**
+     * Read Count words starting at Offset into the domain, at the slowest timing,
+     * as one burst. An empty slot latches the start address once, so every word
+     * of the burst returns the lower 16 bits of the start address.
+     */
+    void (*ReadWords)(void * Context, uint32_t Offset, uint32_t * Out, int Count);
+    void * Context;
+} pi_bus_t;
+
+// Search strategies (values match SWEEP_MODE in dom1speedtest.c)
+typedef enum {
+    PI_SWEEP_EXHAUSTIVE = 0,  // Every PWD at every LAT
+    PI_SWEEP_FRONTIER   = 1,  // Gallop down from the previous LAT's minimum, then bisect
+    PI_SWEEP_BISECT     = 2,  // Bisect 0-255 at every LAT, ignoring the previous LAT
+    NUM_PI_SWEEP_STRATEGIES
+} pi_sweep_strategy_t;
+
+/**
+ * @brief Called after the minimum PWD of a LAT is decided (or filled in)
+ */
+typedef void (*pi_sweep_progress_t)(void * Context, int LAT);
+
+/**
+ * @brief Find the minimum working PWD for one LAT, starting from the previous LAT's minimum
+ *
+ * A higher LAT rarely needs a higher PWD, so the bound is tried first and the
+ * search gallops downward from it and then bisects. If the bound fails, the
+ * range above it is searched instead.
+ * @param Bound Minimum working PWD of the previous LAT (PI_SWEEP_NONE if none found)
+ * @param OutViolation Set to true if the bound did not pass at this LAT
+ * @param OutLanes Set to the AD lines wrong at the PWD just below the result (0 if PWD 0 works)
+ * @return Minimum working PWD for this LAT, PI_SWEEP_NONE if none found
+ */
+uint8_t PiSweepFindMinPWD(const pi_bus_t * Bus, uint8_t LAT, uint8_t Bound, uint8_t PGS, uint8_t RLS,
+                          bool * OutViolation, uint16_t * OutLanes);
+
+/**
+ * @brief Find the minimum working PWD of every LAT
+ *
+ * Every LAT is searched, so with repeatable probes all strategies give the
+ * same table. PI_SWEEP_EXHAUSTIVE probes all 65,536 cells to get it.
+ * @param MinPWDForLAT Filled with 256 entries, PI_SWEEP_NONE where nothing works
+ * @param Violations 256 flags for LATs that needed more than the previous LAT (may be NULL)
+ * @param FailLanes 256 AD line masks wrong just below each minimum (may be NULL)
+ * @param Progress Called for every LAT as it is decided (may be NULL)
+ * @return Number of LATs that needed a higher PWD than the previous LAT
+ */
+int PiSweepRun(const pi_bus_t * Bus, pi_sweep_strategy_t Strategy, uint8_t PGS, uint8_t RLS,
+               uint8_t * MinPWDForLAT, bool * Violations, uint16_t * FailLanes,
+               pi_sweep_progress_t Progress, void * ProgressContext);
+
+/**
+ * @brief Find the lowest PWD at or above a floor that passes, for one LAT
+ *
+ * The floor is tried first. If it fails, the search gallops upward and then
+ * bisects, so a probe that mostly agrees with the floor costs one call.
+ * @param Floor PWD to start from (PI_SWEEP_NONE if none found)
+ * @return Lowest passing PWD at or above Floor, PI_SWEEP_NONE if none passes
+ */
+uint8_t PiSweepRaisePWD(const pi_bus_t * Bus, uint8_t LAT, uint8_t Floor, uint8_t PGS, uint8_t RLS);
+
+/**
+ * @brief Raise an existing frontier until every cell passes another probe
+ *
+ * Re-checks a frontier found by PiSweepRun with a stricter or different probe
+ * (repeated probes, CPU reads) without searching below it. Once 16
+ * consecutive LATs (one matrix row) share a result, the rest of the table is
+ * filled with it.
+ * @param Floor 256 PWDs to start from, PI_SWEEP_NONE where nothing worked
+ * @param PWDForLAT Filled with 256 entries, PI_SWEEP_NONE where nothing passes
+ * @param Progress Called for every LAT as it is decided (may be NULL)
+ * @return Number of LATs whose result differs from the floor
+ */
+int PiSweepRaise(const pi_bus_t * Bus, uint8_t PGS, uint8_t RLS, const uint8_t * Floor,
+                 uint8_t * PWDForLAT, pi_sweep_progress_t Progress, void * ProgressContext);
+
+/**
+ * @brief Check one word read from a domain against the open bus pattern
+ *
+ * Cheap enough for frequent polls (a single PIO read), but a cart word that
+ * happens to hold its own address in either half reads as open bus.
+ * @param Address PI address the word was read from
+ */
+bool PiSweepWordIsOpenBus(uint32_t Address, uint32_t Word);
+
+/**
+ * @brief Check whether anything answers at the start of a domain
+ *
+ * Open bus returns the lower 16 bits of the address, so a domain where every
+ * checked word holds its own address in either half is empty. Each checked
+ * word is read on its own, so it is compared with the address it was read from.
+ * @param BaseAddress PI address of offset 0 (only its lower 16 bits matter)
+ */
+bool PiSweepDetectPresence(const pi_bus_t * Bus, uint32_t BaseAddress);
+
+/**
+ * @brief Short name of a strategy
+ */
+const char * PiSweepStrategyName(pi_sweep_strategy_t Strategy);
+
+#endif // PISWEEP_H
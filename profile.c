@@ -0,0 +1,109 @@
+/**
+ * @file profile.c
+ * @brief Per-phase C0 COUNT instrumentation of the sweep
+ */
+
+#include <string.h>
+#include <libdragon.h>
+
+#include "profile.h"
+
+#ifdef PROFILE_PHASES
+
+// C0 COUNT runs at half the CPU clock
+#define TICKS_TO_CYCLES(t) ((t) * 2)
+
+typedef struct {
+    uint32_t Count;
+    uint64_t TotalTicks;
+    uint32_t MinTicks;
+    uint32_t MaxTicks;
+    uint32_t Buckets[PROFILE_BUCKETS];
+} profile_entry_t;
+
+static const char * PhaseNames[] = {
+    "TestSpeed",
+    "SetSpeed",
+    "Cache",
+    "DMA wait",
+    "Compare",
+    "CartRead",
+    "Reference",
+    "Render"
+};
+
+// Fixed buffer in RDRAM, no allocation while profiling
+static profile_entry_t Entries[NUM_PROFILE_PHASES];
+
+void ProfileRecord(profile_phase_t Phase, uint32_t Ticks) {
+    profile_entry_t * Entry = &Entries[Phase];
+    uint32_t Cycles = TICKS_TO_CYCLES(Ticks);
+
+    if (Entry->Count == 0 || Ticks < Entry->MinTicks) {
+        Entry->MinTicks = Ticks;
+    }
+    if (Ticks > Entry->MaxTicks) {
+        Entry->MaxTicks = Ticks;
+    }
+    Entry->Count++;
+    Entry->TotalTicks += Ticks;
+
+    int Bucket = (Cycles == 0) ? 0 : (31 - __builtin_clz(Cycles));
+    if (Bucket >= PROFILE_BUCKETS) {
+        Bucket = PROFILE_BUCKETS - 1;
+    }
+    Entry->Buckets[Bucket]++;
+}
+
+void ProfileReset(void) {
+    memset(Entries, 0, sizeof(Entries));
+}
+
+void ProfilePrintSummary(void) {
+    console_clear();
+    printf("Sweep profile (CPU cycles)\n\n");
+    printf("Phase          n    min    avg    max\n");
+    debugf("Sweep profile (CPU cycles): phase, count, min, avg, max, total ms\n");
+
+    for (int Phase = 0; Phase < NUM_PROFILE_PHASES; Phase++) {
+        const profile_entry_t * Entry = &Entries[Phase];
+        if (Entry->Count == 0) {
+            printf("%-9s      -\n", PhaseNames[Phase]);
+            continue;
+        }
+
+        uint32_t Avg = (uint32_t)(Entry->TotalTicks / Entry->Count);
+        printf("%-9s %6lu %6lu %6lu %6lu\n", PhaseNames[Phase], (unsigned long)Entry->Count,
+               (unsigned long)TICKS_TO_CYCLES(Entry->MinTicks), (unsigned long)TICKS_TO_CYCLES(Avg),
+               (unsigned long)TICKS_TO_CYCLES(Entry->MaxTicks));
+        debugf("%s, %lu, %lu, %lu, %lu, %lu\n", PhaseNames[Phase], (unsigned long)Entry->Count,
+               (unsigned long)TICKS_TO_CYCLES(Entry->MinTicks), (unsigned long)TICKS_TO_CYCLES(Avg),
+               (unsigned long)TICKS_TO_CYCLES(Entry->MaxTicks),
+               (unsigned long)(Entry->TotalTicks / (TICKS_PER_SECOND / 1000)));
+
+        // Histogram over ISViewer only: "2^N:count" for non-empty buckets
+        debugf("  histogram:");
+        for (int Bucket = 0; Bucket < PROFILE_BUCKETS; Bucket++) {
+            if (Entry->Buckets[Bucket] != 0) {
+                debugf(" 2^%d:%lu", Bucket, (unsigned long)Entry->Buckets[Bucket]);
+            }
+        }
+        debugf("\n");
+    }
+
+    // Share of the sweep spent per phase
+    const profile_entry_t * Total = &Entries[PROFILE_TEST_SPEED];
+    if (Total->TotalTicks != 0) {
+        printf("\nShare of TestSpeed time:\n");
+        for (int Phase = PROFILE_SET_SPEED; Phase <= PROFILE_COMPARE; Phase++) {
+            printf("%-9s %3lu%%\n", PhaseNames[Phase],
+                   (unsigned long)(Entries[Phase].TotalTicks * 100 / Total->TotalTicks));
+        }
+        printf("Render vs TestSpeed: %lu%%\n",
+               (unsigned long)(Entries[PROFILE_RENDER].TotalTicks * 100 / Total->TotalTicks));
+    }
+
+    console_render();
+}
+
+#endif // PROFILE_PHASES
@@ -0,0 +1,59 @@
+/**
+ * @file profile.h
+ * @brief Per-phase C0 COUNT instrumentation of the sweep
+ *
+ * Enabled with -DPROFILE_PHASES. When disabled, PROFILE_BEGIN/PROFILE_END
+ * expand to nothing and no profiling code or data is linked in.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <libdragon.h>
+
+// Can be defined via Makefile: N64_CFLAGS += -DPROFILE_PHASES
+//#define PROFILE_PHASES
+
+// Histogram buckets: bucket N counts samples of 2^N to 2^(N+1)-1 CPU cycles
+#define PROFILE_BUCKETS 24
+
+typedef enum {
+    PROFILE_TEST_SPEED = 0,     // Whole TestSpeed call
+    PROFILE_SET_SPEED,          // SetDom1Speed (includes waiting for the DMA queue to drain)
+    PROFILE_CACHE,              // Cache maintenance around DMA buffers
+    PROFILE_DMA_WAIT,           // Waiting for a DMA to complete
+    PROFILE_COMPARE,            // Comparing against reference data
+    PROFILE_CART_READ,          // Whole blocking CartDom1Read call
+    PROFILE_REFERENCE,          // Whole ReadReferenceData call
+    PROFILE_RENDER,             // Matrix view present
+    NUM_PROFILE_PHASES
+} profile_phase_t;
+
+#ifdef PROFILE_PHASES
+
+#define PROFILE_BEGIN(Name)        uint32_t Name = C0_COUNT()
+#define PROFILE_END(Phase, Name)   ProfileRecord((Phase), C0_COUNT() - (Name))
+
+/**
+ * @brief Add one sample (in C0 COUNT ticks) to a phase
+ */
+void ProfileRecord(profile_phase_t Phase, uint32_t Ticks);
+
+/**
+ * @brief Clear all phases
+ */
+void ProfileReset(void);
+
+/**
+ * @brief Show the min/avg/max summary on the console and send it with the histograms over ISViewer
+ */
+void ProfilePrintSummary(void);
+
+#else
+
+#define PROFILE_BEGIN(Name)
+#define PROFILE_END(Phase, Name)
+
+#endif // PROFILE_PHASES
+
+#endif // PROFILE_H
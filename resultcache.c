@@ -0,0 +1,60 @@
+/**
+ * @file resultcache.c
+ * @brief Speed test results kept in RDRAM across cartridge swaps
+ */
+
+#include <string.h>
+#include <libdragon.h>
+
+#include "resultcache.h"
+
+static result_cache_entry_t Entries[RESULT_CACHE_ENTRIES];
+static uint32_t UseCounter = 0;
+
+static bool KeyMatches(const result_cache_entry_t * Entry, uint32_t Crc1, uint32_t Crc2, const char * Name) {
+    return Entry->Valid && Entry->Crc1 == Crc1 && Entry->Crc2 == Crc2 &&
+           strncmp(Entry->Name, Name, sizeof(Entry->Name)) == 0;
+}
+
+result_cache_entry_t * ResultCacheFind(uint32_t Crc1, uint32_t Crc2, const char * Name) {
+    for (int i = 0; i < RESULT_CACHE_ENTRIES; i++) {
+        if (KeyMatches(&Entries[i], Crc1, Crc2, Name)) {
+            Entries[i].LastUsed = ++UseCounter;
+            return &Entries[i];
+        }
+    }
+    return NULL;
+}
+
+void ResultCacheStore(const result_cache_entry_t * Entry) {
+    // Same cart, else a free slot, else the least recently used one
+    result_cache_entry_t * Slot = NULL;
+    for (int i = 0; i < RESULT_CACHE_ENTRIES && Slot == NULL; i++) {
+        if (KeyMatches(&Entries[i], Entry->Crc1, Entry->Crc2, Entry->Name)) {
+            Slot = &Entries[i];
+        }
+    }
+    for (int i = 0; i < RESULT_CACHE_ENTRIES && Slot == NULL; i++) {
+        if (!Entries[i].Valid) {
+            Slot = &Entries[i];
+        }
+    }
+    if (Slot == NULL) {
+        Slot = &Entries[0];
+        for (int i = 1; i < RESULT_CACHE_ENTRIES; i++) {
+            if (Entries[i].LastUsed < Slot->LastUsed) {
+                Slot = &Entries[i];
+            }
+        }
+    }
+
+    *Slot = *Entry;
+    Slot->Name[sizeof(Slot->Name) - 1] = '\0';
+    Slot->Valid = true;
+    Slot->StoredTicks = get_ticks();
+    Slot->LastUsed = ++UseCounter;
+}
+
+void ResultCacheRemove(result_cache_entry_t * Entry) {
+    Entry->Valid = false;
+}
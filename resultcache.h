@@ -0,0 +1,70 @@
+/**
+ * @file resultcache.h
+ * @brief Speed test results kept in RDRAM across cartridge swaps
+ *
+ * The PIF hang keeps the ROM running while carts are swapped, so results of
+ * carts tested earlier in the session stay in RDRAM. Entries are keyed by the
+ * header CRC1/CRC2 plus the name, and the least recently used entry is evicted
+ * when the cache is full.
+ */
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of carts remembered
+#define RESULT_CACHE_ENTRIES      8
+
+// Sample block offsets remembered per cart (at least NUM_TEST_LOCATIONS)
+#define RESULT_CACHE_MAX_SAMPLES  4
+
+typedef struct {
+    bool Valid;
+    uint32_t Crc1;                // Header CRC1 (key)
+    uint32_t Crc2;                // Header CRC2 (key)
+    char Name[21];                // Header name (key)
+    uint8_t LAT;                  // Chosen timing
+    uint8_t PWD;
+    uint8_t PGS;
+    uint8_t RLS;
+    uint8_t Level;                // speed_level_t of the chosen timing
+    uint32_t KBPerSec;            // Measured throughput of the chosen timing
+    bool HeaderCrcValid;          // Header CRC1/CRC2 matched at slowest speed (verification used them)
+    uint32_t SampleOffsets[RESULT_CACHE_MAX_SAMPLES];  // Blocks TestSpeed probed
+    uint8_t MinPWDForLAT[256];    // Frontier found by the sweep
+    uint16_t FirstFailLanes[256]; // AD lines failing just below the frontier
+    uint8_t PioMinPWDForLAT[256]; // Frontier of the PIO read path
+    uint32_t DmaWordNs;           // Per-word cost of each read path at the chosen timing
+    uint32_t PioWordNs;
+    uint8_t Dom2MinPWDForLAT[256];// Frontier of the save memory (Domain 2)
+    bool Dom2Present;             // Save memory answered on Domain 2
+    bool Dom2Pattern;             // Its contents could show errors (not a blank save)
+    bool Dom2Identified;          // Read as save data, or as a FlashRAM by its ID
+    uint8_t Dom2LAT;              // Fastest Domain 2 timing and its throughput
+    uint8_t Dom2PWD;
+    uint32_t Dom2KBPerSec;
+    uint32_t Dom2DefaultKBPerSec;
+    uint64_t StoredTicks;         // get_ticks() when the entry was stored
+    uint32_t LastUsed;            // LRU stamp
+} result_cache_entry_t;
+
+/**
+ * @brief Look up a cart and mark its entry as most recently used
+ * @return The entry, or NULL if the cart is not cached
+ */
+result_cache_entry_t * ResultCacheFind(uint32_t Crc1, uint32_t Crc2, const char * Name);
+
+/**
+ * @brief Store a result, replacing the entry with the same key or the least recently used one
+ * @param Entry Result to store; StoredTicks and LastUsed are filled in
+ */
+void ResultCacheStore(const result_cache_entry_t * Entry);
+
+/**
+ * @brief Drop an entry (e.g. when its confirmation probe fails)
+ */
+void ResultCacheRemove(result_cache_entry_t * Entry);
+
+#endif // RESULTCACHE_H
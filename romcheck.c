@@ -0,0 +1,263 @@
+/**
+ * @file romcheck.c
+ * @brief ROM header checksum (CRC1/CRC2), header timing patch, streaming hash and data pattern kernels
+ */
+
+#include <stddef.h>
+
+#include "romcheck.h"
+
+// Checksum seeds per CIC family
+#define CIC_SEED_6102  0xF8CA4DDC  // 6101, 6102, 7102
+#define CIC_SEED_6103  0xA3886759
+#define CIC_SEED_6105  0xDF26F436
+#define CIC_SEED_6106  0x1FEA617A
+
+// CRC32 of the boot code (ROM 0x40-0xFFF) for each known CIC
+static const struct {
+    uint32_t Crc;
+    cic_type_t Cic;
+} CicBootCodeCrcs[] = {
+    { 0x6170A4A1, CIC_6101 },
+    { 0x90BB6CB5, CIC_6102 },
+    { 0x0B050EE0, CIC_6103 },
+    { 0x98BC2C86, CIC_6105 },
+    { 0xACC8580A, CIC_6106 },
+    { 0x009E9EA3, CIC_7102 },
+};
+
+static const char * CicNames[] = {
+    "unknown",
+    "6101",
+    "6102",
+    "6103",
+    "6105",
+    "6106",
+    "7102"
+};
+
+/**
+ * @brief Load a big-endian word from a 4-byte aligned buffer
+ */
+static inline uint32_t LoadWord(const uint8_t * Data) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return *(const uint32_t *)Data;
+#else
+    return RomReadWord(Data);
+#endif
+}
+
+/**
+ * @brief Load a big-endian doubleword from an 8-byte aligned buffer
+ */
+static inline uint64_t LoadDoubleWord(const uint8_t * Data) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return *(const uint64_t *)Data;
+#else
+    return ((uint64_t)RomReadWord(Data) << 32) | RomReadWord(Data + 4);
+#endif
+}
+
+uint32_t RomCrc32Update(uint32_t Crc, const uint8_t * Data, uint32_t Len) {
+    for (uint32_t i = 0; i < Len; i++) {
+        Crc ^= Data[i];
+        for (int Bit = 0; Bit < 8; Bit++) {
+            Crc = (Crc >> 1) ^ (0xEDB88320 & -(Crc & 1));
+        }
+    }
+    return Crc;
+}
+
+uint32_t RomCrc32Final(uint32_t Crc) {
+    return ~Crc;
+}
+
+uint32_t RomCrc32(const uint8_t * Data, uint32_t Len) {
+    return RomCrc32Final(RomCrc32Update(ROM_CRC32_INIT, Data, Len));
+}
+
+cic_type_t RomDetectCic(const uint8_t * BootRegion) {
+    uint32_t Crc = RomCrc32(BootRegion + ROM_HEADER_SIZE, ROM_BOOT_REGION_SIZE - ROM_HEADER_SIZE);
+    for (size_t i = 0; i < sizeof(CicBootCodeCrcs) / sizeof(CicBootCodeCrcs[0]); i++) {
+        if (CicBootCodeCrcs[i].Crc == Crc) {
+            return CicBootCodeCrcs[i].Cic;
+        }
+    }
+    return CIC_UNKNOWN;
+}
+
+const char * RomCicName(cic_type_t Cic) {
+    return CicNames[Cic];
+}
+
+uint32_t RomReadWord(const uint8_t * Data) {
+    return ((uint32_t)Data[0] << 24) | ((uint32_t)Data[1] << 16) | ((uint32_t)Data[2] << 8) | Data[3];
+}
+
+uint32_t RomMakeTimingWord(uint32_t StockWord, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS) {
+    return (StockWord & 0xFF000000) |
+           ((uint32_t)(((RLS & 0x03) << 4) | (PGS & 0x0F)) << 16) |
+           ((uint32_t)PWD << 8) |
+           LAT;
+}
+
+void RomParseTimingWord(uint32_t Word, uint8_t * OutLAT, uint8_t * OutPWD, uint8_t * OutPGS, uint8_t * OutRLS) {
+    *OutLAT = (uint8_t)Word;
+    *OutPWD = (uint8_t)(Word >> 8);
+    *OutPGS = (uint8_t)((Word >> 16) & 0x0F);
+    *OutRLS = (uint8_t)((Word >> 20) & 0x03);
+}
+
+void RomMakeIpsWordPatch(uint32_t Offset, uint32_t Word, uint8_t * Out) {
+    static const uint8_t Header[5] = { 'P', 'A', 'T', 'C', 'H' };
+    static const uint8_t Footer[3] = { 'E', 'O', 'F' };
+    uint8_t * Record = Out + sizeof(Header);
+
+    for (size_t i = 0; i < sizeof(Header); i++) {
+        Out[i] = Header[i];
+    }
+    Record[0] = (uint8_t)(Offset >> 16);
+    Record[1] = (uint8_t)(Offset >> 8);
+    Record[2] = (uint8_t)Offset;
+    Record[3] = 0;
+    Record[4] = 4;
+    Record[5] = (uint8_t)(Word >> 24);
+    Record[6] = (uint8_t)(Word >> 16);
+    Record[7] = (uint8_t)(Word >> 8);
+    Record[8] = (uint8_t)Word;
+    for (size_t i = 0; i < sizeof(Footer); i++) {
+        Record[9 + i] = Footer[i];
+    }
+}
+
+void RomChecksumInit(rom_checksum_t * State, cic_type_t Cic, const uint8_t * BootRegion) {
+    uint32_t Seed;
+    switch (Cic) {
+        case CIC_6103: Seed = CIC_SEED_6103; break;
+        case CIC_6105: Seed = CIC_SEED_6105; break;
+        case CIC_6106: Seed = CIC_SEED_6106; break;
+        default:       Seed = CIC_SEED_6102; break;
+    }
+
+    State->T1 = State->T2 = State->T3 = State->T4 = State->T5 = State->T6 = Seed;
+    State->Cic = Cic;
+    State->BootRegion = BootRegion;
+    State->Offset = ROM_CHECKSUM_START;
+}
+
+void RomChecksumUpdate(rom_checksum_t * State, const uint8_t * Data, uint32_t Len) {
+    // Work on locals so the loop stays in registers
+    uint32_t T1 = State->T1, T2 = State->T2, T3 = State->T3;
+    uint32_t T4 = State->T4, T5 = State->T5, T6 = State->T6;
+    uint32_t Offset = State->Offset;
+    bool Is6105 = (State->Cic == CIC_6105);
+
+    for (uint32_t i = 0; i < Len; i += 4, Offset += 4) {
+        uint32_t D = LoadWord(Data + i);
+
+        if (T6 + D < T6) {
+            T4++;
+        }
+        T6 += D;
+        T3 ^= D;
+
+        uint32_t Shift = D & 0x1F;
+        uint32_t R = (D << Shift) | (D >> ((32 - Shift) & 0x1F));
+        T5 += R;
+
+        if (T2 > D) {
+            T2 ^= R;
+        } else {
+            T2 ^= T6 ^ D;
+        }
+
+        if (Is6105) {
+            // 6105 mixes in a word of its own boot code
+            T1 += LoadWord(State->BootRegion + ROM_HEADER_SIZE + 0x0710 + (Offset & 0xFF)) ^ D;
+        } else {
+            T1 += T5 ^ D;
+        }
+    }
+
+    State->T1 = T1; State->T2 = T2; State->T3 = T3;
+    State->T4 = T4; State->T5 = T5; State->T6 = T6;
+    State->Offset = Offset;
+}
+
+void RomChecksumFinal(const rom_checksum_t * State, uint32_t * OutCrc1, uint32_t * OutCrc2) {
+    switch (State->Cic) {
+        case CIC_6103:
+            *OutCrc1 = (State->T6 ^ State->T4) + State->T3;
+            *OutCrc2 = (State->T5 ^ State->T2) + State->T1;
+            break;
+        case CIC_6106:
+            *OutCrc1 = (State->T6 * State->T4) + State->T3;
+            *OutCrc2 = (State->T5 * State->T2) + State->T1;
+            break;
+        default:
+            *OutCrc1 = State->T6 ^ State->T4 ^ State->T3;
+            *OutCrc2 = State->T5 ^ State->T2 ^ State->T1;
+            break;
+    }
+}
+
+uint32_t RomHashUpdate(uint32_t Hash, const uint8_t * Data, uint32_t Len) {
+    for (uint32_t i = 0; i < Len; i += 4) {
+        Hash = (Hash ^ LoadWord(Data + i)) * 0x01000193;
+        Hash ^= Hash >> 15;
+    }
+    return Hash;
+}
+
+uint32_t RomToggleDensity(const uint8_t * Block, uint32_t Len) {
+    uint32_t Toggles = 0;
+    uint32_t Previous = LoadWord(Block) >> 16;  // No transition into the first halfword
+
+    for (uint32_t i = 0; i < Len; i += 4) {
+        uint32_t Word = LoadWord(Block + i);
+
+        // High half: previous low halfword -> high halfword, low half: high -> low halfword
+        uint32_t X = Word ^ ((Word >> 16) | (Previous << 16));
+        Previous = Word;
+
+        // Population count
+        X = X - ((X >> 1) & 0x55555555);
+        X = (X & 0x33333333) + ((X >> 2) & 0x33333333);
+        X = (X + (X >> 4)) & 0x0F0F0F0F;
+        Toggles += (X * 0x01010101) >> 24;
+    }
+
+    return Toggles;
+}
+
+uint32_t RomCompareLanes(const uint8_t * Data, const uint8_t * Reference, uint32_t Len, uint16_t * OutLaneMask) {
+    // Fast path: two words per iteration, leaves at the first row that differs
+    uint32_t First = 0;
+    while (First < Len &&
+           ((LoadDoubleWord(Data + First) ^ LoadDoubleWord(Reference + First)) |
+            (LoadDoubleWord(Data + First + 8) ^ LoadDoubleWord(Reference + First + 8))) == 0) {
+        First += 16;
+    }
+    if (First == Len) {
+        *OutLaneMask = 0;
+        return 0;
+    }
+
+    // Mismatch: fold every differing halfword from that row on onto the AD lines and count them
+    uint64_t Lanes = 0;
+    uint32_t Errors = 0;
+    for (uint32_t i = First; i < Len; i += 8) {
+        uint64_t Diff = LoadDoubleWord(Data + i) ^ LoadDoubleWord(Reference + i);
+        if (Diff == 0) {
+            continue;
+        }
+        Lanes |= Diff;
+        for (int Shift = 0; Shift < 64; Shift += 16) {
+            Errors += ((Diff >> Shift) & 0xFFFF) != 0;
+        }
+    }
+    Lanes |= Lanes >> 32;
+    Lanes |= Lanes >> 16;
+    *OutLaneMask = (uint16_t)Lanes;
+    return Errors;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file romcheck.h
+ * @brief ROM header checksum (CRC1/CRC2), header timing patch, streaming hash and data pattern kernels
+ *
+ * The header checksum is the one the IPL3 boot code verifies: it covers the 1MB
+ * following the boot code and depends on the CIC chip, which is identified from
+ * a CRC32 of the boot code.
+ */
+
+#ifndef ROMCHECK_H
+#define ROMCHECK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ROM layout
+#define ROM_HEADER_SIZE      0x40
+#define ROM_TIMING_OFFSET    0x00        // PI_BSD_DOM1 timing the IPL programs before booting
+#define ROM_BOOT_REGION_SIZE 0x1000      // Header + IPL3 boot code
+#define ROM_CRC1_OFFSET      0x10
+#define ROM_CRC2_OFFSET      0x14
+#define ROM_CHECKSUM_START   0x1000
+#define ROM_CHECKSUM_LENGTH  0x100000    // 1MB covered by CRC1/CRC2
+
+// IPS patch of one ROM word: "PATCH", one record (3-byte offset, 2-byte size, data), "EOF"
+#define ROM_IPS_WORD_PATCH_SIZE (5 + 3 + 2 + 4 + 3)
+
+// Initial value for RomHashUpdate
+#define ROM_HASH_SEED        0x811C9DC5
+
+typedef enum {
+    CIC_UNKNOWN = 0,
+    CIC_6101,
+    CIC_6102,
+    CIC_6103,
+    CIC_6105,
+    CIC_6106,
+    CIC_7102
+} cic_type_t;
+
+/**
+ * @brief Running state of the header checksum over the checksummed region
+ */
+typedef struct {
+    uint32_t T1, T2, T3, T4, T5, T6;
+    cic_type_t Cic;
+    const uint8_t * BootRegion;  // Needed by the 6105 variant, which mixes in boot code words
+    uint32_t Offset;             // ROM offset of the next word
+} rom_checksum_t;
+
+// Initial value for RomCrc32Update
+#define ROM_CRC32_INIT       0xFFFFFFFF
+
+/**
+ * @brief Standard (reflected, 0xEDB88320) CRC32
+ */
+uint32_t RomCrc32(const uint8_t * Data, uint32_t Len);
+
+/**
+ * @brief Fold data into a running CRC32
+ * @param Crc ROM_CRC32_INIT to start, finish with RomCrc32Final
+ */
+uint32_t RomCrc32Update(uint32_t Crc, const uint8_t * Data, uint32_t Len);
+
+/**
+ * @brief Finish a running CRC32
+ */
+uint32_t RomCrc32Final(uint32_t Crc);
+
+/**
+ * @brief Identify the CIC from the boot code
+ * @param BootRegion First ROM_BOOT_REGION_SIZE bytes of the ROM
+ */
+cic_type_t RomDetectCic(const uint8_t * BootRegion);
+
+/**
+ * @brief Printable CIC name ("6102", "unknown", ...)
+ */
+const char * RomCicName(cic_type_t Cic);
+
+/**
+ * @brief Read a big-endian word from a byte buffer
+ */
+uint32_t RomReadWord(const uint8_t * Data);
+
+/**
+ * @brief Build a header timing word, keeping the first byte of the stock word
+ *
+ * Byte 1 holds RLS in the high nibble and PGS in the low nibble, byte 2 is PWD
+ * and byte 3 is LAT (0x80371240 is LAT 0x40, PWD 0x12, PGS 7, RLS 3).
+ */
+uint32_t RomMakeTimingWord(uint32_t StockWord, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS);
+
+/**
+ * @brief Split a header timing word into LAT/PWD/PGS/RLS
+ */
+void RomParseTimingWord(uint32_t Word, uint8_t * OutLAT, uint8_t * OutPWD, uint8_t * OutPGS, uint8_t * OutRLS);
+
+/**
+ * @brief Build an IPS patch that replaces one big-endian word of a .z64 image
+ * @param Offset File offset of the word (below 0x454F46, which IPS reads as "EOF")
+ * @param Out Buffer of ROM_IPS_WORD_PATCH_SIZE bytes
+ */
+void RomMakeIpsWordPatch(uint32_t Offset, uint32_t Word, uint8_t * Out);
+
+/**
+ * @brief Start a header checksum computation
+ * @param BootRegion First ROM_BOOT_REGION_SIZE bytes of the ROM (must stay valid)
+ */
+void RomChecksumInit(rom_checksum_t * State, cic_type_t Cic, const uint8_t * BootRegion);
+
+/**
+ * @brief Feed the next part of the checksummed region (starting at ROM_CHECKSUM_START)
+ * @param Data Big-endian ROM data, Len a multiple of 4
+ */
+void RomChecksumUpdate(rom_checksum_t * State, const uint8_t * Data, uint32_t Len);
+
+/**
+ * @brief Finish the header checksum computation
+ */
+void RomChecksumFinal(const rom_checksum_t * State, uint32_t * OutCrc1, uint32_t * OutCrc2);
+
+/**
+ * @brief Fold data into a rolling 32-bit hash (word-wise multiply/xorshift)
+ * @param Hash Previous hash, ROM_HASH_SEED to start
+ * @param Len Multiple of 4
+ */
+uint32_t RomHashUpdate(uint32_t Hash, const uint8_t * Data, uint32_t Len);
+
+/**
+ * @brief Count bit transitions between consecutive halfwords of a block
+ *
+ * Blocks with many toggling data lines (0x5555/0xAAAA alternations, all-ones
+ * after all-zeros) are the first to fail at tight PI timings.
+ * @param Block Big-endian ROM data, 4-byte aligned
+ * @param Len Multiple of 4
+ * @return Number of data-line toggles over the block (at most 16 per halfword)
+ */
+uint32_t RomToggleDensity(const uint8_t * Block, uint32_t Len);
+
+/**
+ * @brief Compare a block against reference data a 64-bit word at a time
+ *
+ * The fast path XORs two word pairs per 16-byte row and stops at the first
+ * row that differs, so a matching block is read once. From that row on the
+ * differences are folded onto the 16 AD lines: bit n of the mask is set if
+ * line ADn returned a wrong bit anywhere in the block.
+ * @param Data Data read over the PI, 8-byte aligned
+ * @param Reference Expected data, 8-byte aligned
+ * @param Len Multiple of 16
+ * @param OutLaneMask Failing AD lines, 0 if the block matches
+ * @return Number of halfwords that differ
+ */
+uint32_t RomCompareLanes(const uint8_t * Data, const uint8_t * Reference, uint32_t Len, uint16_t * OutLaneMask);
+
+#endif // ROMCHECK_H
@@ -0,0 +1,247 @@
+/**
+ * @file rspverify.c
+ * @brief Probe compares and stream hashes on the RSP
+ */
+
+#include <string.h>
+#include <libdragon.h>
+
+#include "rspverify.h"
+
+DEFINE_RSP_UCODE(rsp_verify);
+
+// SP registers used besides what rsp_load/rsp_run_async program
+static volatile uint32_t * const SP_dmem = (uint32_t *)0xA4000000;
+static volatile uint32_t * const SP_status = (uint32_t *)0xA4040010;
+
+#define SP_STATUS_HALTED         (1 << 0)
+#define SP_WSTATUS_SET_HALT      (1 << 1)
+#define SP_WSTATUS_CLEAR_BROKE   (1 << 2)
+
+// A 32KB hash job takes well under a millisecond
+#define RSP_VERIFY_TIMEOUT_TICKS (TICKS_PER_SECOND / 100)
+
+static bool Available = false;
+static bool Enabled = true;
+static bool Running = false;
+static bool RspqClosed = false;  // The RSP was taken from rspq and has to be handed back
+static uint32_t Posted = 0;   // Jobs handed to the running task
+
+/**
+ * @brief Take the RSP from rspq, which must not run while the task does
+ */
+static void TakeRsp(void) {
+    if (!RspqClosed) {
+        rspq_wait();
+        rdpq_close();
+        rspq_close();
+        RspqClosed = true;
+    }
+}
+
+/**
+ * @brief Hand the halted RSP back to rspq and rdpq
+ */
+static void ReturnRsp(void) {
+    if (RspqClosed) {
+        rspq_init();
+        rdpq_init();
+        RspqClosed = false;
+    }
+}
+
+/**
+ * @brief Halt the RSP and use the CPU from now on
+ */
+static void GiveUp(void) {
+    *SP_status = SP_WSTATUS_SET_HALT | SP_WSTATUS_CLEAR_BROKE;
+    Available = false;
+    Running = false;
+    ReturnRsp();
+    debugf("RSP verify: no answer from the RSP, using the CPU\n");
+}
+
+/**
+ * @brief Wait until the task has finished at least Count jobs
+ */
+static bool WaitDone(uint32_t Count) {
+    uint32_t Start = C0_COUNT();
+    while ((int32_t)(SP_dmem[RSP_VERIFY_DONE / 4] - Count) < 0) {
+        if (C0_COUNT() - Start > RSP_VERIFY_TIMEOUT_TICKS) {
+            GiveUp();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Start the task with an empty mailbox
+ */
+static void StartTask(void) {
+    TakeRsp();
+    rsp_load(&rsp_verify);
+    SP_dmem[RSP_VERIFY_POSTED / 4] = 0;
+    SP_dmem[RSP_VERIFY_DONE / 4] = 0;
+    Posted = 0;
+    MEMORY_BARRIER();
+    rsp_run_async();
+    Running = true;
+}
+
+/**
+ * @brief Write a job into its slot and publish it
+ */
+static int32_t Post(const void * Data, const void * Reference, uint32_t Len, uint32_t Type) {
+    assert((Len % 16) == 0 && Len > 0);
+    assert(((uint32_t)Data & 7) == 0 && ((uint32_t)Reference & 7) == 0);
+
+    if (!Available || !Enabled) {
+        return -1;
+    }
+    if (!Running) {
+        StartTask();
+    }
+
+    // Reuse a slot only once the task is done with its previous job
+    if (Posted >= RSP_VERIFY_MAX_JOBS && !WaitDone(Posted - RSP_VERIFY_MAX_JOBS + 1)) {
+        return -1;
+    }
+
+    uint32_t Slot = RSP_VERIFY_JOBS / 4 + (Posted % RSP_VERIFY_MAX_JOBS) * 4;
+    SP_dmem[Slot + 0] = PhysicalAddr(Data);
+    SP_dmem[Slot + 1] = PhysicalAddr(Reference);
+    SP_dmem[Slot + 2] = Len;
+    SP_dmem[Slot + 3] = Type;
+    MEMORY_BARRIER();
+    SP_dmem[RSP_VERIFY_POSTED / 4] = ++Posted;
+    return (int32_t)(Posted - 1);
+}
+
+bool RspVerifyInit(void) {
+    static uint8_t Pattern[RSP_VERIFY_CHUNK + 256] __attribute__ ((aligned(16)));
+    static uint8_t Flipped[sizeof(Pattern)] __attribute__ ((aligned(16)));
+
+    // rspq gets the RSP back when the self-test ends
+    TakeRsp();
+    rsp_init();
+    Available = true;
+
+    // Spans more than one DMEM chunk; one bit of AD5 differs near the end
+    for (uint32_t i = 0; i < sizeof(Pattern); i++) {
+        Pattern[i] = (uint8_t)(i * 37 + (i >> 8));
+    }
+    memcpy(Flipped, Pattern, sizeof(Flipped));
+    Flipped[sizeof(Flipped) - 5] ^= 0x20;
+    data_cache_hit_writeback(Pattern, sizeof(Pattern));
+    data_cache_hit_writeback(Flipped, sizeof(Flipped));
+
+    int32_t Same = RspVerifyPostCompare(Pattern, Pattern, sizeof(Pattern));
+    int32_t Differ = RspVerifyPostCompare(Pattern, Flipped, sizeof(Pattern));
+    int32_t Hash = RspVerifyPostHash(Pattern, sizeof(Pattern));
+    if (Hash < 0 || !RspVerifyWait(Hash)) {
+        return false;
+    }
+
+    uint8_t Signature[RSP_VERIFY_SIGNATURE_SIZE];
+    uint8_t Expected[RSP_VERIFY_SIGNATURE_SIZE];
+    RspVerifySignature(Hash, Signature);
+    RspVerifySignatureCpu(Pattern, sizeof(Pattern), Expected);
+    bool Correct = RspVerifyLanes(Same) == 0 && RspVerifyLanes(Differ) == 0x0020 &&
+                   memcmp(Signature, Expected, sizeof(Signature)) == 0;
+    RspVerifyStop();
+
+    if (!Correct) {
+        debugf("RSP verify: self-test failed, using the CPU\n");
+        Available = false;
+    }
+    return Available;
+}
+
+bool RspVerifyAvailable(void) {
+    return Available && Enabled;
+}
+
+void RspVerifySetEnabled(bool Enable) {
+    if (!Enable) {
+        RspVerifyStop();
+    }
+    Enabled = Enable;
+}
+
+int32_t RspVerifyPostCompare(const void * Data, const void * Reference, uint32_t Len) {
+    return Post(Data, Reference, Len, RSP_VERIFY_TYPE_COMPARE);
+}
+
+int32_t RspVerifyPostHash(const void * Data, uint32_t Len) {
+    return Post(Data, Data, Len, RSP_VERIFY_TYPE_HASH);
+}
+
+bool RspVerifyWait(int32_t Job) {
+    return Available && WaitDone((uint32_t)Job + 1);
+}
+
+uint16_t RspVerifyLanes(int32_t Job) {
+    uint32_t Slot = RSP_VERIFY_RESULTS / 4 + ((uint32_t)Job % RSP_VERIFY_MAX_JOBS) * (RSP_VERIFY_SIGNATURE_SIZE / 4);
+    uint32_t Diff = SP_dmem[Slot] | SP_dmem[Slot + 1] | SP_dmem[Slot + 2] | SP_dmem[Slot + 3];
+    return (uint16_t)(Diff | (Diff >> 16));
+}
+
+void RspVerifySignature(int32_t Job, uint8_t * Out) {
+    uint32_t Slot = RSP_VERIFY_RESULTS / 4 + ((uint32_t)Job % RSP_VERIFY_MAX_JOBS) * (RSP_VERIFY_SIGNATURE_SIZE / 4);
+    for (int i = 0; i < RSP_VERIFY_SIGNATURE_SIZE / 4; i++) {
+        uint32_t Word = SP_dmem[Slot + i];
+        Out[i * 4 + 0] = (uint8_t)(Word >> 24);
+        Out[i * 4 + 1] = (uint8_t)(Word >> 16);
+        Out[i * 4 + 2] = (uint8_t)(Word >> 8);
+        Out[i * 4 + 3] = (uint8_t)Word;
+    }
+}
+
+void RspVerifySignatureCpu(const uint8_t * Data, uint32_t Len, uint8_t * Out) {
+    uint16_t Sum[8] = { 0 };
+    uint16_t SumOfSums[8] = { 0 };
+
+    for (uint32_t i = 0; i < Len; i += 16) {
+        for (int Lane = 0; Lane < 8; Lane++) {
+            uint16_t Halfword = (uint16_t)((Data[i + Lane * 2] << 8) | Data[i + Lane * 2 + 1]);
+            Sum[Lane] += Halfword;
+            SumOfSums[Lane] += Sum[Lane];
+        }
+    }
+    for (int Lane = 0; Lane < 8; Lane++) {
+        Out[Lane * 2] = (uint8_t)(Sum[Lane] >> 8);
+        Out[Lane * 2 + 1] = (uint8_t)Sum[Lane];
+        Out[16 + Lane * 2] = (uint8_t)(SumOfSums[Lane] >> 8);
+        Out[16 + Lane * 2 + 1] = (uint8_t)SumOfSums[Lane];
+    }
+}
+
+void RspVerifyStop(void) {
+    if (!Running) {
+        ReturnRsp();
+        return;
+    }
+
+    // A zero-length job ends the task; it acknowledges it before halting
+    uint32_t Slot = RSP_VERIFY_JOBS / 4 + (Posted % RSP_VERIFY_MAX_JOBS) * 4;
+    if (Posted >= RSP_VERIFY_MAX_JOBS && !WaitDone(Posted - RSP_VERIFY_MAX_JOBS + 1)) {
+        return;
+    }
+    SP_dmem[Slot + 2] = 0;
+    MEMORY_BARRIER();
+    SP_dmem[RSP_VERIFY_POSTED / 4] = ++Posted;
+    if (!WaitDone(Posted)) {
+        return;
+    }
+
+    uint32_t Start = C0_COUNT();
+    while (!(*SP_status & SP_STATUS_HALTED)) {
+        if (C0_COUNT() - Start > RSP_VERIFY_TIMEOUT_TICKS) {
+            GiveUp();
+            return;
+        }
+    }
+    Running = false;
+    ReturnRsp();
+}
@@ -0,0 +1,106 @@
+/**
+ * @file rspverify.h
+ * @brief Probe compares and stream hashes on the RSP
+ *
+ * The RSP task (rsp_verify.S) polls a small mailbox in DMEM, so the CPU can
+ * post a job as soon as a PI DMA completes and go back to driving the PI.
+ * A job is a buffer in RDRAM and either a reference to compare it with (the
+ * result is the mask of AD lines that differ) or nothing (the result is a
+ * Fletcher checksum per halfword lane). When the RSP does not answer in
+ * time it is disabled for the rest of the session and callers use the CPU.
+ *
+ * While the task runs it owns the RSP: rdpq and rspq are closed when it
+ * starts and initialized again when RspVerifyStop halts it.
+ */
+
+#ifndef RSPVERIFY_H
+#define RSPVERIFY_H
+
+// Jobs in flight (power of two)
+#define RSP_VERIFY_MAX_JOBS        16
+
+// Bytes moved into DMEM per step; job lengths must be a multiple of 16
+#define RSP_VERIFY_CHUNK           1024
+
+// DMEM layout (must match rsp_verify.S)
+#define RSP_VERIFY_POSTED          0x000  // Jobs posted by the CPU
+#define RSP_VERIFY_DONE            0x004  // Jobs finished by the RSP
+#define RSP_VERIFY_JOBS            0x010  // { Data, Reference, Len, Type } per slot
+#define RSP_VERIFY_RESULTS         0x110  // 32 bytes per slot
+#define RSP_VERIFY_DATA            0x400  // Buffer chunk
+#define RSP_VERIFY_REFERENCE       0x800  // Reference chunk
+
+// Job types
+#define RSP_VERIFY_TYPE_COMPARE    0
+#define RSP_VERIFY_TYPE_HASH       1
+
+// Size of a hash result: 8 lanes of sums, then 8 lanes of sums of sums
+#define RSP_VERIFY_SIGNATURE_SIZE  32
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Load the microcode and check it on known data
+ * @return false if the RSP gave a wrong answer or none (the CPU path is used)
+ */
+bool RspVerifyInit(void);
+
+/**
+ * @brief Whether jobs can be posted (RspVerifyInit passed, the RSP has not timed out and it is enabled)
+ */
+bool RspVerifyAvailable(void);
+
+/**
+ * @brief Let callers post jobs, or stop the task and refuse them (-1) so rspq can use the RSP
+ */
+void RspVerifySetEnabled(bool Enable);
+
+/**
+ * @brief Post a compare job, starting the task if needed
+ * @param Data Buffer (8-byte aligned, not dirty in the data cache)
+ * @param Reference Expected contents (same rules)
+ * @param Len Bytes, a multiple of 16
+ * @return Job number for RspVerifyWait, or -1 if the RSP stopped answering
+ */
+int32_t RspVerifyPostCompare(const void * Data, const void * Reference, uint32_t Len);
+
+/**
+ * @brief Post a hash job, starting the task if needed
+ * @return Job number for RspVerifyWait, or -1 if the RSP stopped answering
+ */
+int32_t RspVerifyPostHash(const void * Data, uint32_t Len);
+
+/**
+ * @brief Wait for a job posted less than RSP_VERIFY_MAX_JOBS jobs ago
+ * @return false if the RSP stopped answering
+ */
+bool RspVerifyWait(int32_t Job);
+
+/**
+ * @brief AD lines that differed in a finished compare job (0 if the data matched)
+ */
+uint16_t RspVerifyLanes(int32_t Job);
+
+/**
+ * @brief Copy the signature of a finished hash job
+ */
+void RspVerifySignature(int32_t Job, uint8_t * Out);
+
+/**
+ * @brief Compute the signature of a hash job on the CPU
+ *
+ * Gives the same bytes as the RSP, so a stream can switch paths midway.
+ */
+void RspVerifySignatureCpu(const uint8_t * Data, uint32_t Len, uint8_t * Out);
+
+/**
+ * @brief Let the task finish, halt the RSP and hand it back to rspq
+ */
+void RspVerifyStop(void);
+
+#endif // __ASSEMBLER__
+
+#endif // RSPVERIFY_H
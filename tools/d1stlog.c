@@ -0,0 +1,605 @@
+/**
+ * @file d1stlog.c
+ * @brief Host tool: collect Dom1SpeedTest result records from ISViewer logs
+ *
+ * Scans logs for #D1ST: records (see export.h), drops any whose CRC32 does not
+ * match, and writes the carts as CSV or as an SQL script for sqlite3. With -i,
+ * each cart's header timing patch is also written to <crc1>-<crc2>.ips:
+ *
+ *   d1stlog run1.log run2.log > carts.csv
+ *   d1stlog -p run1.log > points.csv
+ *   d1stlog -s *.log | sqlite3 fleet.db
+ *   d1stlog -i *.log > /dev/null
+ *
+ * With no files the log is read from stdin.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define EXPORT_PREFIX   "#D1ST:"
+#define EXPORT_VERSION  1
+
+#define MAX_LINE        4096
+#define MAX_POINTS      1024
+#define MAX_IPS_SIZE    64
+#define NUM_LOADS       4      // RDRAM loads of a CONTENTION_BENCH ROM (bus_load_t)
+
+static const char * LoadNames[NUM_LOADS] = { "off", "16bpp", "32bpp", "rdp" };
+
+typedef enum {
+    OUTPUT_CARTS_CSV,
+    OUTPUT_POINTS_CSV,
+    OUTPUT_SQL
+} output_mode_t;
+
+typedef struct {
+    unsigned LAT, PWD, PGS, RLS;
+    unsigned long KBPerSec;
+    unsigned long PredictedKBPerSec;
+    int Failed;
+} point_t;
+
+typedef struct {
+    char Name[64];
+    char Cic[16];
+    unsigned long Crc1, Crc2;
+    int CrcOk;
+    unsigned LAT, PWD, PGS, RLS;
+    unsigned long KBPerSec;
+    unsigned long ModelPercent;
+    int Level;
+    unsigned long Probes, SweepMs, PiMs, WaitMs;
+    int Violations, StepBacks;
+    char MinTable[256 * 2 + 1];
+    char SafeTable[256 * 2 + 1];  // Empty unless the ROM was built with MARGIN_TEST
+    char LaneTable[256 * 4 + 1];  // Failing AD lines per LAT
+    char PioTable[256 * 2 + 1];   // Minimum PWD of the PIO read path
+    unsigned long DmaWordNs, PioWordNs;
+    int PioStricter;
+    int Dom2Present;              // Save memory (Domain 2) answered
+    unsigned Dom2LAT, Dom2PWD;
+    unsigned long Dom2KBPerSec, Dom2DefaultKBPerSec;
+    char Dom2Table[256 * 2 + 1];  // Empty when no save memory answered
+    int WriteTested;              // 0 unless the ROM was built with WRITE_TEST
+    int WritePresent;             // Writable Domain 1 memory was found
+    unsigned WriteLAT, WritePWD;
+    unsigned long WriteKBPerSec, WriteDefaultKBPerSec;
+    char WriteTable[256 * 2 + 1];  // Empty when no writable memory was found
+    int LatencyVerdict;           // 0 unless the ROM was built with DMA_LATENCY
+    long LatencyOffset16, LatencySlope;
+    char LatencyTable[256 * 4 + 1];  // Bus ns per halfword at each LAT's minimum PWD, empty without DMA_LATENCY
+    char XferStrictest[16];       // Strictest DMA transfer profile, empty without TRANSFER_PROFILES
+    int XferStricter;             // LATs where it needs a higher PWD than the samples
+    char XferTable[256 * 2 + 1];  // Minimum PWD of the strictest profile
+    char LoadWorst[16];           // RDRAM load with the most stricter LATs, empty without CONTENTION_BENCH
+    int LoadStricter;             // LATs where it needs a higher PWD than with the display off
+    char LoadTable[256 * 2 + 1];  // Minimum PWD under that load
+    unsigned long LoadKBPerSec[NUM_LOADS];  // Chosen timing under each load, 0 if not run
+    int LoadFails;                // Loads under which the chosen timing failed a probe
+    unsigned long HeaderWord, PatchedWord;  // Header timing word, 0 when the stock one is already as fast
+    unsigned long BootUs, PatchedBootUs;
+    unsigned char Ips[MAX_IPS_SIZE];        // Header patch for a .z64 image
+    size_t IpsSize;
+    point_t Points[MAX_POINTS];
+    int NumPoints;
+} cart_record_t;
+
+static output_mode_t Mode = OUTPUT_CARTS_CSV;
+static int WriteIps = 0;
+static unsigned long RecordsSeen = 0;
+static unsigned long RecordsBad = 0;
+static unsigned long CartsWritten = 0;
+
+static uint32_t Crc32Update(uint32_t Crc, const char * Data, size_t Len) {
+    for (size_t i = 0; i < Len; i++) {
+        Crc ^= (uint8_t)Data[i];
+        for (int Bit = 0; Bit < 8; Bit++) {
+            Crc = (Crc >> 1) ^ (0xEDB88320 & -(Crc & 1));
+        }
+    }
+    return Crc;
+}
+
+/**
+ * @brief Write a CSV field, quoted when it contains separators or quotes
+ */
+static void PrintCsvString(const char * Text) {
+    if (strpbrk(Text, ",\"") == NULL) {
+        fputs(Text, stdout);
+        return;
+    }
+    putchar('"');
+    for (; *Text != '\0'; Text++) {
+        if (*Text == '"') {
+            putchar('"');
+        }
+        putchar(*Text);
+    }
+    putchar('"');
+}
+
+/**
+ * @brief Write an SQL string literal
+ */
+static void PrintSqlString(const char * Text) {
+    putchar('\'');
+    for (; *Text != '\0'; Text++) {
+        if (*Text == '\'') {
+            putchar('\'');
+        }
+        putchar(*Text);
+    }
+    putchar('\'');
+}
+
+static void PrintHeader(void) {
+    switch (Mode) {
+        case OUTPUT_CARTS_CSV:
+            printf("source,name,crc1,crc2,cic,crc_ok,lat,pwd,pgs,rls,kbps,model_percent,level,"
+                   "probes,sweep_ms,pi_ms,wait_ms,violations,stepbacks,min_pwd,safe_pwd,fail_lanes,pio_min_pwd,dma_word_ns,pio_word_ns,pio_stricter,"
+                   "dom2_present,dom2_lat,dom2_pwd,dom2_kbps,dom2_default_kbps,dom2_min_pwd,"
+                   "write_present,write_lat,write_pwd,write_kbps,write_default_kbps,write_min_pwd,"
+                   "latency_verdict,latency_offset16,latency_slope,latency_ns,"
+                   "xfer_strictest,xfer_stricter,xfer_min_pwd,"
+                   "load_worst,load_stricter,load_min_pwd,load_off_kbps,load_16bpp_kbps,load_32bpp_kbps,load_rdp_kbps,load_fails,"
+                   "header_word,patched_word,boot_us,patched_boot_us\n");
+            break;
+        case OUTPUT_POINTS_CSV:
+            printf("source,name,crc1,crc2,lat,pwd,pgs,rls,kbps,predicted_kbps,verify_failed\n");
+            break;
+        case OUTPUT_SQL:
+            printf("CREATE TABLE IF NOT EXISTS carts (id INTEGER PRIMARY KEY, source TEXT, name TEXT, "
+                   "crc1 TEXT, crc2 TEXT, cic TEXT, crc_ok INTEGER, lat INTEGER, pwd INTEGER, pgs INTEGER, "
+                   "rls INTEGER, kbps INTEGER, model_percent INTEGER, level INTEGER, probes INTEGER, "
+                   "sweep_ms INTEGER, pi_ms INTEGER, wait_ms INTEGER, violations INTEGER, stepbacks INTEGER, "
+                   "min_pwd TEXT, safe_pwd TEXT, fail_lanes TEXT, pio_min_pwd TEXT, dma_word_ns INTEGER, "
+                   "pio_word_ns INTEGER, pio_stricter INTEGER, dom2_present INTEGER, dom2_lat INTEGER, "
+                   "dom2_pwd INTEGER, dom2_kbps INTEGER, dom2_default_kbps INTEGER, dom2_min_pwd TEXT, "
+                   "write_present INTEGER, write_lat INTEGER, write_pwd INTEGER, write_kbps INTEGER, "
+                   "write_default_kbps INTEGER, write_min_pwd TEXT, "
+                   "latency_verdict INTEGER, latency_offset16 INTEGER, latency_slope INTEGER, latency_ns TEXT, "
+                   "xfer_strictest TEXT, xfer_stricter INTEGER, xfer_min_pwd TEXT, "
+                   "load_worst TEXT, load_stricter INTEGER, load_min_pwd TEXT, load_off_kbps INTEGER, "
+                   "load_16bpp_kbps INTEGER, load_32bpp_kbps INTEGER, load_rdp_kbps INTEGER, load_fails INTEGER, "
+                   "header_word TEXT, patched_word TEXT, boot_us INTEGER, patched_boot_us INTEGER);\n");
+            printf("CREATE TABLE IF NOT EXISTS points (cart_id INTEGER REFERENCES carts(id), lat INTEGER, "
+                   "pwd INTEGER, pgs INTEGER, rls INTEGER, kbps INTEGER, predicted_kbps INTEGER, "
+                   "verify_failed INTEGER);\n");
+            printf("BEGIN TRANSACTION;\n");
+            break;
+    }
+}
+
+static void PrintFooter(void) {
+    if (Mode == OUTPUT_SQL) {
+        printf("COMMIT;\n");
+    }
+}
+
+static void PrintCart(const char * Source, const cart_record_t * Cart) {
+    switch (Mode) {
+        case OUTPUT_CARTS_CSV:
+            PrintCsvString(Source);
+            putchar(',');
+            PrintCsvString(Cart->Name);
+            printf(",%08lX,%08lX,%s,%d,%u,%u,%u,%u,%lu,%lu,%d,%lu,%lu,%lu,%lu,%d,%d,%s,%s,%s,%s,%lu,%lu,%d,%d,%u,%u,%lu,%lu,%s,%d,%u,%u,%lu,%lu,%s,%d,%ld,%ld,%s,%s,%d,%s,%s,%d,%s,%lu,%lu,%lu,%lu,%d,%08lX,%08lX,%lu,%lu\n",
+                   Cart->Crc1, Cart->Crc2, Cart->Cic, Cart->CrcOk,
+                   Cart->LAT, Cart->PWD, Cart->PGS, Cart->RLS,
+                   Cart->KBPerSec, Cart->ModelPercent, Cart->Level,
+                   Cart->Probes, Cart->SweepMs, Cart->PiMs, Cart->WaitMs,
+                   Cart->Violations, Cart->StepBacks, Cart->MinTable, Cart->SafeTable, Cart->LaneTable,
+                   Cart->PioTable, Cart->DmaWordNs, Cart->PioWordNs, Cart->PioStricter,
+                   Cart->Dom2Present, Cart->Dom2LAT, Cart->Dom2PWD, Cart->Dom2KBPerSec,
+                   Cart->Dom2DefaultKBPerSec, Cart->Dom2Table,
+                   Cart->WritePresent, Cart->WriteLAT, Cart->WritePWD, Cart->WriteKBPerSec,
+                   Cart->WriteDefaultKBPerSec, Cart->WriteTable,
+                   Cart->LatencyVerdict, Cart->LatencyOffset16, Cart->LatencySlope, Cart->LatencyTable,
+                   Cart->XferStrictest, Cart->XferStricter, Cart->XferTable,
+                   Cart->LoadWorst, Cart->LoadStricter, Cart->LoadTable, Cart->LoadKBPerSec[0],
+                   Cart->LoadKBPerSec[1], Cart->LoadKBPerSec[2], Cart->LoadKBPerSec[3], Cart->LoadFails,
+                   Cart->HeaderWord, Cart->PatchedWord, Cart->BootUs, Cart->PatchedBootUs);
+            break;
+        case OUTPUT_POINTS_CSV:
+            for (int i = 0; i < Cart->NumPoints; i++) {
+                const point_t * Point = &Cart->Points[i];
+                PrintCsvString(Source);
+                putchar(',');
+                PrintCsvString(Cart->Name);
+                printf(",%08lX,%08lX,%u,%u,%u,%u,%lu,%lu,%d\n",
+                       Cart->Crc1, Cart->Crc2, Point->LAT, Point->PWD, Point->PGS, Point->RLS,
+                       Point->KBPerSec, Point->PredictedKBPerSec, Point->Failed);
+            }
+            break;
+        case OUTPUT_SQL:
+            printf("INSERT INTO carts (source, name, crc1, crc2, cic, crc_ok, lat, pwd, pgs, rls, kbps, "
+                   "model_percent, level, probes, sweep_ms, pi_ms, wait_ms, violations, stepbacks, min_pwd, safe_pwd, fail_lanes, pio_min_pwd, dma_word_ns, pio_word_ns, pio_stricter, "
+                   "dom2_present, dom2_lat, dom2_pwd, dom2_kbps, dom2_default_kbps, dom2_min_pwd, "
+                   "write_present, write_lat, write_pwd, write_kbps, write_default_kbps, write_min_pwd, "
+                   "latency_verdict, latency_offset16, latency_slope, latency_ns, "
+                   "xfer_strictest, xfer_stricter, xfer_min_pwd, "
+                   "load_worst, load_stricter, load_min_pwd, load_off_kbps, load_16bpp_kbps, load_32bpp_kbps, "
+                   "load_rdp_kbps, load_fails, "
+                   "header_word, patched_word, boot_us, patched_boot_us) VALUES (");
+            PrintSqlString(Source);
+            putchar(',');
+            PrintSqlString(Cart->Name);
+            printf(",'%08lX','%08lX','%s',%d,%u,%u,%u,%u,%lu,%lu,%d,%lu,%lu,%lu,%lu,%d,%d,'%s',",
+                   Cart->Crc1, Cart->Crc2, Cart->Cic, Cart->CrcOk,
+                   Cart->LAT, Cart->PWD, Cart->PGS, Cart->RLS,
+                   Cart->KBPerSec, Cart->ModelPercent, Cart->Level,
+                   Cart->Probes, Cart->SweepMs, Cart->PiMs, Cart->WaitMs,
+                   Cart->Violations, Cart->StepBacks, Cart->MinTable);
+            if (Cart->SafeTable[0] != '\0') {
+                printf("'%s',", Cart->SafeTable);
+            } else {
+                printf("NULL,");
+            }
+            printf("'%s','%s',%lu,%lu,%d,%d,%u,%u,%lu,%lu,", Cart->LaneTable, Cart->PioTable,
+                   Cart->DmaWordNs, Cart->PioWordNs, Cart->PioStricter,
+                   Cart->Dom2Present, Cart->Dom2LAT, Cart->Dom2PWD, Cart->Dom2KBPerSec, Cart->Dom2DefaultKBPerSec);
+            if (Cart->Dom2Table[0] != '\0') {
+                printf("'%s',", Cart->Dom2Table);
+            } else {
+                printf("NULL,");
+            }
+            if (Cart->WriteTested) {
+                printf("%d,%u,%u,%lu,%lu,", Cart->WritePresent, Cart->WriteLAT, Cart->WritePWD,
+                       Cart->WriteKBPerSec, Cart->WriteDefaultKBPerSec);
+            } else {
+                printf("NULL,NULL,NULL,NULL,NULL,");
+            }
+            if (Cart->WriteTable[0] != '\0') {
+                printf("'%s',", Cart->WriteTable);
+            } else {
+                printf("NULL,");
+            }
+            printf("%d,%ld,%ld,", Cart->LatencyVerdict, Cart->LatencyOffset16, Cart->LatencySlope);
+            if (Cart->LatencyTable[0] != '\0') {
+                printf("'%s',", Cart->LatencyTable);
+            } else {
+                printf("NULL,");
+            }
+            if (Cart->XferStrictest[0] != '\0') {
+                printf("'%s',%d,'%s',", Cart->XferStrictest, Cart->XferStricter, Cart->XferTable);
+            } else {
+                printf("NULL,NULL,NULL,");
+            }
+            if (Cart->LoadWorst[0] != '\0') {
+                printf("'%s',%d,'%s',%lu,%lu,%lu,%lu,%d,", Cart->LoadWorst, Cart->LoadStricter, Cart->LoadTable,
+                       Cart->LoadKBPerSec[0], Cart->LoadKBPerSec[1], Cart->LoadKBPerSec[2], Cart->LoadKBPerSec[3],
+                       Cart->LoadFails);
+            } else {
+                printf("NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,");
+            }
+            if (Cart->PatchedWord != 0) {
+                printf("'%08lX','%08lX',%lu,%lu);\n", Cart->HeaderWord, Cart->PatchedWord,
+                       Cart->BootUs, Cart->PatchedBootUs);
+            } else {
+                printf("NULL,NULL,NULL,NULL);\n");
+            }
+            for (int i = 0; i < Cart->NumPoints; i++) {
+                const point_t * Point = &Cart->Points[i];
+                printf("INSERT INTO points VALUES ((SELECT MAX(id) FROM carts), %u, %u, %u, %u, %lu, %lu, %d);\n",
+                       Point->LAT, Point->PWD, Point->PGS, Point->RLS,
+                       Point->KBPerSec, Point->PredictedKBPerSec, Point->Failed);
+            }
+            break;
+    }
+    CartsWritten++;
+}
+
+/**
+ * @brief Write the cart's header patch to <crc1>-<crc2>.ips in the current directory
+ */
+static void WriteIpsFile(const cart_record_t * Cart) {
+    char FileName[32];
+    if (Cart->IpsSize == 0) {
+        return;
+    }
+    snprintf(FileName, sizeof(FileName), "%08lX-%08lX.ips", Cart->Crc1, Cart->Crc2);
+    FILE * File = fopen(FileName, "wb");
+    if (File == NULL || fwrite(Cart->Ips, 1, Cart->IpsSize, File) != Cart->IpsSize) {
+        perror(FileName);
+    }
+    if (File != NULL) {
+        fclose(File);
+    }
+}
+
+/**
+ * @brief Parse one record line (text after the prefix) into the cart
+ * @return 0 on success, -1 if the line is malformed
+ */
+static int ParseCartLine(const char * Line, cart_record_t * Cart) {
+    if (strncmp(Line, "NAME ", 5) == 0) {
+        snprintf(Cart->Name, sizeof(Cart->Name), "%s", Line + 5);
+        return 0;
+    }
+    if (strncmp(Line, "NAME", 4) == 0 && Line[4] == '\0') {
+        Cart->Name[0] = '\0';
+        return 0;
+    }
+    if (strncmp(Line, "HDR ", 4) == 0) {
+        return sscanf(Line, "HDR crc1=%lx crc2=%lx cic=%15s crcok=%d",
+                      &Cart->Crc1, &Cart->Crc2, Cart->Cic, &Cart->CrcOk) == 4 ? 0 : -1;
+    }
+    if (strncmp(Line, "BEST ", 5) == 0) {
+        return sscanf(Line, "BEST lat=%x pwd=%x pgs=%x rls=%x kbps=%lu model=%lu level=%d",
+                      &Cart->LAT, &Cart->PWD, &Cart->PGS, &Cart->RLS,
+                      &Cart->KBPerSec, &Cart->ModelPercent, &Cart->Level) == 7 ? 0 : -1;
+    }
+    if (strncmp(Line, "STAT ", 5) == 0) {
+        return sscanf(Line, "STAT probes=%lu sweep_ms=%lu pi_ms=%lu wait_ms=%lu violations=%d stepbacks=%d",
+                      &Cart->Probes, &Cart->SweepMs, &Cart->PiMs, &Cart->WaitMs,
+                      &Cart->Violations, &Cart->StepBacks) == 6 ? 0 : -1;
+    }
+    if (strncmp(Line, "MIN ", 4) == 0) {
+        if (strlen(Line + 4) != 256 * 2) {
+            return -1;
+        }
+        memcpy(Cart->MinTable, Line + 4, sizeof(Cart->MinTable));
+        return 0;
+    }
+    if (strncmp(Line, "SAFE ", 5) == 0) {
+        if (strlen(Line + 5) != 256 * 2) {
+            return -1;
+        }
+        memcpy(Cart->SafeTable, Line + 5, sizeof(Cart->SafeTable));
+        return 0;
+    }
+    if (strncmp(Line, "PIOMIN ", 7) == 0) {
+        if (strlen(Line + 7) != 256 * 2) {
+            return -1;
+        }
+        memcpy(Cart->PioTable, Line + 7, sizeof(Cart->PioTable));
+        return 0;
+    }
+    if (strncmp(Line, "PIO ", 4) == 0) {
+        unsigned long Probes;
+        return sscanf(Line, "PIO dma_ns=%lu pio_ns=%lu stricter=%d probes=%lu",
+                      &Cart->DmaWordNs, &Cart->PioWordNs, &Cart->PioStricter, &Probes) == 4 ? 0 : -1;
+    }
+    if (strncmp(Line, "LANES ", 6) == 0) {
+        if (strlen(Line + 6) != 256 * 4) {
+            return -1;
+        }
+        memcpy(Cart->LaneTable, Line + 6, sizeof(Cart->LaneTable));
+        return 0;
+    }
+    if (strncmp(Line, "DOM2 ", 5) == 0) {
+        return sscanf(Line, "DOM2 present=%d lat=%x pwd=%x kbps=%lu default_kbps=%lu",
+                      &Cart->Dom2Present, &Cart->Dom2LAT, &Cart->Dom2PWD,
+                      &Cart->Dom2KBPerSec, &Cart->Dom2DefaultKBPerSec) == 5 ? 0 : -1;
+    }
+    if (strncmp(Line, "DOM2MIN ", 8) == 0) {
+        if (strlen(Line + 8) != 256 * 2) {
+            return -1;
+        }
+        memcpy(Cart->Dom2Table, Line + 8, sizeof(Cart->Dom2Table));
+        return 0;
+    }
+    if (strncmp(Line, "WRITE ", 6) == 0) {
+        Cart->WriteTested = 1;
+        return sscanf(Line, "WRITE present=%d lat=%x pwd=%x kbps=%lu default_kbps=%lu",
+                      &Cart->WritePresent, &Cart->WriteLAT, &Cart->WritePWD,
+                      &Cart->WriteKBPerSec, &Cart->WriteDefaultKBPerSec) == 5 ? 0 : -1;
+    }
+    if (strncmp(Line, "WRITEMIN ", 9) == 0) {
+        if (strlen(Line + 9) != 256 * 2) {
+            return -1;
+        }
+        memcpy(Cart->WriteTable, Line + 9, sizeof(Cart->WriteTable));
+        return 0;
+    }
+    if (strncmp(Line, "LATENCY ", 8) == 0) {
+        return sscanf(Line, "LATENCY verdict=%d offset16=%ld slope=%ld",
+                      &Cart->LatencyVerdict, &Cart->LatencyOffset16, &Cart->LatencySlope) == 3 ? 0 : -1;
+    }
+    if (strncmp(Line, "LATNS ", 6) == 0) {
+        if (strlen(Line + 6) != 256 * 4) {
+            return -1;
+        }
+        memcpy(Cart->LatencyTable, Line + 6, sizeof(Cart->LatencyTable));
+        return 0;
+    }
+    if (strncmp(Line, "XFER ", 5) == 0) {
+        return sscanf(Line, "XFER strictest=%15s stricter=%d",
+                      Cart->XferStrictest, &Cart->XferStricter) == 2 ? 0 : -1;
+    }
+    if (strncmp(Line, "XFERMIN ", 8) == 0) {
+        // One line per swept profile; only the strictest one is kept
+        const char * Table = strchr(Line + 8, ' ');
+        if (Table == NULL || strlen(Table + 1) != 256 * 2) {
+            return -1;
+        }
+        if ((size_t)(Table - (Line + 8)) == strlen(Cart->XferStrictest) &&
+            strncmp(Line + 8, Cart->XferStrictest, strlen(Cart->XferStrictest)) == 0) {
+            memcpy(Cart->XferTable, Table + 1, sizeof(Cart->XferTable));
+        }
+        return 0;
+    }
+    if (strncmp(Line, "CONTENTION ", 11) == 0) {
+        return sscanf(Line, "CONTENTION worst=%15s stricter=%d",
+                      Cart->LoadWorst, &Cart->LoadStricter) == 2 ? 0 : -1;
+    }
+    if (strncmp(Line, "LOAD ", 5) == 0) {
+        char Name[16];
+        unsigned long KBPerSec;
+        int Pass, Stricter;
+        if (sscanf(Line, "LOAD %15s kbps=%lu pass=%d stricter=%d", Name, &KBPerSec, &Pass, &Stricter) != 4) {
+            return -1;
+        }
+        for (int i = 0; i < NUM_LOADS; i++) {
+            if (strcmp(Name, LoadNames[i]) == 0) {
+                Cart->LoadKBPerSec[i] = KBPerSec;
+            }
+        }
+        if (!Pass) {
+            Cart->LoadFails++;
+        }
+        return 0;
+    }
+    if (strncmp(Line, "LOADMIN ", 8) == 0) {
+        // One line per load; only the worst one is kept
+        const char * Table = strchr(Line + 8, ' ');
+        if (Table == NULL || strlen(Table + 1) != 256 * 2) {
+            return -1;
+        }
+        if ((size_t)(Table - (Line + 8)) == strlen(Cart->LoadWorst) &&
+            strncmp(Line + 8, Cart->LoadWorst, strlen(Cart->LoadWorst)) == 0) {
+            memcpy(Cart->LoadTable, Table + 1, sizeof(Cart->LoadTable));
+        }
+        return 0;
+    }
+    if (strncmp(Line, "HDRPATCH ", 9) == 0) {
+        return sscanf(Line, "HDRPATCH stock=%lx patched=%lx boot_us=%lu patched_boot_us=%lu",
+                      &Cart->HeaderWord, &Cart->PatchedWord, &Cart->BootUs, &Cart->PatchedBootUs) == 4 ? 0 : -1;
+    }
+    if (strncmp(Line, "IPS ", 4) == 0) {
+        const char * Hex = Line + 4;
+        size_t Len = strlen(Hex);
+        if (Len == 0 || (Len % 2) != 0 || Len / 2 > MAX_IPS_SIZE) {
+            return -1;
+        }
+        for (size_t i = 0; i < Len / 2; i++) {
+            unsigned Byte;
+            if (sscanf(Hex + i * 2, "%2x", &Byte) != 1) {
+                return -1;
+            }
+            Cart->Ips[i] = (unsigned char)Byte;
+        }
+        Cart->IpsSize = Len / 2;
+        return 0;
+    }
+    if (strncmp(Line, "PT ", 3) == 0) {
+        if (Cart->NumPoints >= MAX_POINTS) {
+            return -1;
+        }
+        point_t * Point = &Cart->Points[Cart->NumPoints];
+        if (sscanf(Line, "PT lat=%x pwd=%x pgs=%x rls=%x kbps=%lu pred=%lu fail=%d",
+                   &Point->LAT, &Point->PWD, &Point->PGS, &Point->RLS,
+                   &Point->KBPerSec, &Point->PredictedKBPerSec, &Point->Failed) != 7) {
+            return -1;
+        }
+        Cart->NumPoints++;
+        return 0;
+    }
+    // Unknown keys are skipped so newer ROMs can add fields
+    return 0;
+}
+
+/**
+ * @brief Collect every valid CART record from one log
+ */
+static void ProcessLog(FILE * File, const char * Source) {
+    static cart_record_t Cart;
+    char Buffer[MAX_LINE];
+    int InRecord = 0;       // Inside a BEGIN..END block
+    int IsCart = 0;         // The current record is a CART record
+    int Malformed = 0;
+    uint32_t Crc = 0;
+
+    while (fgets(Buffer, sizeof(Buffer), File) != NULL) {
+        // Records may be prefixed by emulator or flashcart log decoration
+        char * Line = strstr(Buffer, EXPORT_PREFIX);
+        if (Line == NULL) {
+            continue;
+        }
+        Line += strlen(EXPORT_PREFIX);
+        Line[strcspn(Line, "\r\n")] = '\0';
+
+        if (strncmp(Line, "BEGIN ", 6) == 0) {
+            int Version = 0;
+            char Type[16] = "";
+            if (InRecord) {
+                RecordsBad++;  // Previous record never ended
+            }
+            RecordsSeen++;
+            InRecord = 1;
+            Malformed = 0;
+            IsCart = (sscanf(Line, "BEGIN %d %15s", &Version, Type) == 2 &&
+                      Version == EXPORT_VERSION && strcmp(Type, "CART") == 0);
+            memset(&Cart, 0, sizeof(Cart));
+            Crc = Crc32Update(0xFFFFFFFF, Line, strlen(Line));
+            Crc = Crc32Update(Crc, "\n", 1);
+            continue;
+        }
+        if (!InRecord) {
+            continue;
+        }
+        if (strncmp(Line, "END ", 4) == 0) {
+            unsigned long Expected = 0;
+            InRecord = 0;
+            if (sscanf(Line, "END crc=%lx", &Expected) != 1 || Expected != (~Crc & 0xFFFFFFFFUL) || Malformed) {
+                RecordsBad++;
+                fprintf(stderr, "%s: dropping corrupted record %lu\n", Source, RecordsSeen);
+                continue;
+            }
+            if (IsCart) {
+                PrintCart(Source, &Cart);
+                if (WriteIps) {
+                    WriteIpsFile(&Cart);
+                }
+            }
+            continue;
+        }
+
+        Crc = Crc32Update(Crc, Line, strlen(Line));
+        Crc = Crc32Update(Crc, "\n", 1);
+        if (IsCart && ParseCartLine(Line, &Cart) != 0) {
+            Malformed = 1;
+        }
+    }
+    if (InRecord) {
+        RecordsBad++;
+        fprintf(stderr, "%s: log ends inside record %lu\n", Source, RecordsSeen);
+    }
+}
+
+static void Usage(const char * Program) {
+    fprintf(stderr, "Usage: %s [-c | -p | -s] [-i] [log...]\n"
+                    "  -c  one CSV row per cart (default)\n"
+                    "  -p  one CSV row per measured frontier point\n"
+                    "  -s  SQL script for sqlite3 (carts and points tables)\n"
+                    "  -i  also write each cart's header timing patch to <crc1>-<crc2>.ips\n", Program);
+}
+
+int main(int argc, char ** argv) {
+    int First = 1;
+    for (; First < argc && argv[First][0] == '-' && argv[First][1] != '\0'; First++) {
+        if (strcmp(argv[First], "-c") == 0) {
+            Mode = OUTPUT_CARTS_CSV;
+        } else if (strcmp(argv[First], "-p") == 0) {
+            Mode = OUTPUT_POINTS_CSV;
+        } else if (strcmp(argv[First], "-s") == 0) {
+            Mode = OUTPUT_SQL;
+        } else if (strcmp(argv[First], "-i") == 0) {
+            WriteIps = 1;
+        } else {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    PrintHeader();
+    if (First == argc) {
+        ProcessLog(stdin, "stdin");
+    }
+    for (int i = First; i < argc; i++) {
+        FILE * File = fopen(argv[i], "r");
+        if (File == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+        ProcessLog(File, argv[i]);
+        fclose(File);
+    }
+    PrintFooter();
+
+    fprintf(stderr, "%lu record(s), %lu cart(s) written, %lu dropped\n",
+            RecordsSeen, CartsWritten, RecordsBad);
+    return 0;
+}
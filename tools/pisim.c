@@ -0,0 +1,370 @@
+/**
+ * @file pisim.c
+ * @brief Host tool: benchmark the sweep strategies against a simulated PI bus
+ *
+ * Runs pisweep.c natively against synthetic carts. Each cart has its own
+ * LAT/PWD pass region, probe noise near the frontier, marginal cells that
+ * sometimes pass below it, and some slots hold no cart at all (open bus).
+ * Probes are charged with the PI timing model, so strategies can be compared
+ * by probe count, simulated bus time and how often they got the frontier or
+ * the chosen timing wrong:
+ *
+ *   pisim                     2000 carts with the default noise
+ *   pisim -c 10000 -n 0 -f 0  noise-free carts, checks the search logic alone
+ *
+ * Runs are reproducible for a given seed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pisweep.h"
+#include "pimodel.h"
+
+// Domain 1 as TestSpeed reads it: four 128-byte sample blocks, one DMA each
+#define SIM_DOM1_START        0x10000000
+#define SIM_SAMPLE_SPANS      4
+#define SIM_SPAN_LEN          128
+
+// RCP cycles to program the four timing registers before a probe
+#define SIM_SET_TIMING_CYCLES 16
+
+// Timing used for every probe of the LAT/PWD sweep
+#define SIM_PGS               0x07
+#define SIM_RLS               0x03
+
+// Transfer size the chosen timing is ranked by (MODEL_WORKLOAD_SIZE in the ROM)
+#define SIM_WORKLOAD_SIZE     0x10000
+
+// MinPWD value of a LAT where no PWD passes
+#define SIM_NEVER             0x100
+
+typedef struct {
+    bool Present;             // false: the slot is empty and reads return open bus
+    uint16_t MinPWD[256];     // Lowest passing PWD per LAT, SIM_NEVER where nothing passes
+    uint16_t WeakLanes;       // AD lines that fail first just below the frontier
+    uint32_t HeaderWord2;     // Boot address in the header, read by the presence check
+} sim_cart_t;
+
+typedef struct {
+    const sim_cart_t * Cart;
+    uint32_t Rng;
+    uint32_t Probes;
+    uint64_t BusCycles;
+} sim_bus_t;
+
+typedef struct {
+    uint64_t Probes;
+    uint32_t MaxProbes;
+    uint64_t BusCycles;
+    uint64_t ExactLATs;       // Result equals the true minimum
+    uint64_t UnsafeLATs;      // Result below the true minimum (would fail in use)
+    uint64_t SlowLATs;        // Result above the true minimum
+    uint32_t ExactCarts;      // All 256 LATs exact
+    uint32_t DiffCarts;       // Table differs from the exhaustive sweep of the same cart
+    uint32_t UnsafePicks;     // Fastest timing of the result fails on the real cart
+    double PickLoss;          // Sum of throughput lost against the true best timing (fraction)
+} sim_stats_t;
+
+// Simulation parameters (set from the command line)
+static uint32_t NumCarts = 2000;
+static uint32_t Seed = 1;
+static uint32_t NoisePpm = 200;       // Failure rate of passing cells close to the frontier
+static int NoiseWidth = 2;            // PWD steps above the frontier that are noisy
+static uint32_t FlakePpm = 50;        // Pass rate of the cell just below the frontier
+static int ViolationPercent = 10;     // Carts whose minimum PWD rises somewhere as LAT rises
+static int OpenBusPercent = 5;        // Empty slots
+
+/**
+ * @brief xorshift32, good enough for synthetic carts and noise
+ */
+static uint32_t Random(uint32_t * State) {
+    uint32_t x = *State;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *State = x;
+    return x;
+}
+
+/**
+ * @brief True with the given probability in parts per million
+ */
+static bool Chance(uint32_t * State, uint32_t Ppm) {
+    return (Random(State) % 1000000) < Ppm;
+}
+
+/**
+ * @brief Make a synthetic cart
+ *
+ * The minimum PWD falls linearly from its LAT 0 value to a floor at a random
+ * knee, like the staircase real carts show. Some carts have dead LATs at the
+ * bottom, and some have a short bump where a higher LAT needs a higher PWD.
+ */
+static void MakeCart(sim_cart_t * Cart, uint32_t * Rng) {
+    memset(Cart, 0, sizeof(*Cart));
+    Cart->Present = (int)(Random(Rng) % 100) >= OpenBusPercent;
+    Cart->WeakLanes = (uint16_t)(1u << (Random(Rng) % 16));
+    Cart->HeaderWord2 = 0x80000400 + (Random(Rng) % 0x100) * 0x100;
+
+    int Floor = 2 + (int)(Random(Rng) % 0x10);
+    int Start = Floor + (int)(Random(Rng) % 0x30);
+    int Knee = 1 + (int)(Random(Rng) % 64);
+    for (int LAT = 0; LAT < 256; LAT++) {
+        int PWD = Start - (Start - Floor) * LAT / Knee;
+        Cart->MinPWD[LAT] = (uint16_t)(PWD > Floor ? PWD : Floor);
+    }
+
+    if (Random(Rng) % 100 < 20) {
+        int DeadLATs = 1 + (int)(Random(Rng) % 4);
+        for (int LAT = 0; LAT < DeadLATs; LAT++) {
+            Cart->MinPWD[LAT] = SIM_NEVER;
+        }
+    }
+
+    if ((int)(Random(Rng) % 100) < ViolationPercent) {
+        int First = 1 + (int)(Random(Rng) % 200);
+        int Last = First + (int)(Random(Rng) % 8);
+        int Bump = 1 + (int)(Random(Rng) % 3);
+        for (int LAT = First; LAT <= Last; LAT++) {
+            if (Cart->MinPWD[LAT] != SIM_NEVER) {
+                Cart->MinPWD[LAT] = (uint16_t)(Cart->MinPWD[LAT] + Bump > 0xFF ? 0xFF : Cart->MinPWD[LAT] + Bump);
+            }
+        }
+    }
+}
+
+static bool SimProbe(void * Context, uint8_t LAT, uint8_t PWD, uint8_t PGS, uint8_t RLS, uint16_t * OutLanes) {
+    sim_bus_t * Bus = Context;
+    uint16_t MinPWD = Bus->Cart->MinPWD[LAT];
+
+    // TestSpeed queues every sample block before comparing, so a probe costs all of them
+    Bus->Probes++;
+    Bus->BusCycles += SIM_SET_TIMING_CYCLES;
+    for (int i = 0; i < SIM_SAMPLE_SPANS; i++) {
+        Bus->BusCycles += PiModelCycles(LAT, PWD, PGS, RLS, SIM_SPAN_LEN);
+    }
+
+    bool Works;
+    if (MinPWD == SIM_NEVER) {
+        Works = false;
+    } else if (PWD >= MinPWD) {
+        Works = !(PWD < MinPWD + NoiseWidth && Chance(&Bus->Rng, NoisePpm));
+    } else {
+        Works = (PWD + 1 == MinPWD && Chance(&Bus->Rng, FlakePpm));
+    }
+
+    if (!Works) {
+        *OutLanes = (MinPWD != SIM_NEVER && PWD + 1 >= MinPWD) ? Bus->Cart->WeakLanes : 0xFFFF;
+    }
+    return Works;
+}
+
+static void SimReadWords(void * Context, uint32_t Offset, uint32_t * Out, int Count) {
+    sim_bus_t * Bus = Context;
+
+    Bus->BusCycles += SIM_SET_TIMING_CYCLES + PiModelCycles(0xFF, 0xFF, SIM_PGS, SIM_RLS, Count * 4);
+    // An empty slot latches the address once per burst, so every halfword of
+    // the read returns the lower 16 bits of the address the burst started at
+    uint32_t Latched = (SIM_DOM1_START + Offset) & 0xFFFF;
+    for (int i = 0; i < Count; i++) {
+        if (!Bus->Cart->Present) {
+            Out[i] = (Latched << 16) | Latched;
+        } else if (i == 0) {
+            Out[i] = 0x80371240;
+        } else if (i == 2) {
+            Out[i] = Bus->Cart->HeaderWord2;
+        } else {
+            Out[i] = 0x0000000F * (uint32_t)(i + 1);
+        }
+    }
+}
+
+/**
+ * @brief Fastest LAT by the timing model, given a minimum PWD table
+ * @return LAT, or -1 if no LAT works
+ */
+static int PickFastestLAT(const uint8_t * MinPWD) {
+    int Best = -1;
+    uint32_t BestCycles = 0;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        if (MinPWD[LAT] == PI_SWEEP_NONE) {
+            continue;
+        }
+        uint32_t Cycles = PiModelCycles((uint8_t)LAT, MinPWD[LAT], SIM_PGS, SIM_RLS, SIM_WORKLOAD_SIZE);
+        if (Best < 0 || Cycles < BestCycles) {
+            Best = LAT;
+            BestCycles = Cycles;
+        }
+    }
+    return Best;
+}
+
+/**
+ * @brief Sweep one cart with one strategy and add the outcome to the stats
+ * @param Found Filled with the strategy's 256-entry table
+ */
+static void RunCart(const sim_cart_t * Cart, uint32_t CartSeed, pi_sweep_strategy_t Strategy, sim_stats_t * Stats,
+                    uint8_t * Found) {
+    sim_bus_t Sim = { Cart, CartSeed, 0, 0 };
+    pi_bus_t Bus = { SimProbe, SimReadWords, &Sim };
+    uint8_t Truth[256];
+
+    PiSweepRun(&Bus, Strategy, SIM_PGS, SIM_RLS, Found, NULL, NULL, NULL, NULL);
+
+    int Exact = 0;
+    for (int LAT = 0; LAT < 256; LAT++) {
+        Truth[LAT] = (Cart->MinPWD[LAT] == SIM_NEVER) ? PI_SWEEP_NONE : (uint8_t)Cart->MinPWD[LAT];
+        if (Found[LAT] == Truth[LAT]) {
+            Exact++;
+        } else if (Found[LAT] < Truth[LAT]) {
+            Stats->UnsafeLATs++;
+        } else {
+            Stats->SlowLATs++;
+        }
+    }
+    Stats->ExactLATs += Exact;
+    if (Exact == 256) {
+        Stats->ExactCarts++;
+    }
+
+    // Would the timing the ROM picks from this table actually work, and how fast is it?
+    int Picked = PickFastestLAT(Found);
+    int Best = PickFastestLAT(Truth);
+    if (Picked >= 0 && Best >= 0) {
+        if (Found[Picked] < Truth[Picked]) {
+            Stats->UnsafePicks++;
+        } else {
+            double PickedKB = PiModelKBPerSec((uint8_t)Picked, Found[Picked], SIM_PGS, SIM_RLS, SIM_WORKLOAD_SIZE);
+            double BestKB = PiModelKBPerSec((uint8_t)Best, Truth[Best], SIM_PGS, SIM_RLS, SIM_WORKLOAD_SIZE);
+            Stats->PickLoss += (BestKB > PickedKB) ? (BestKB - PickedKB) / BestKB : 0.0;
+        }
+    }
+
+    Stats->Probes += Sim.Probes;
+    Stats->BusCycles += Sim.BusCycles;
+    if (Sim.Probes > Stats->MaxProbes) {
+        Stats->MaxProbes = Sim.Probes;
+    }
+}
+
+static void Usage(const char * Program) {
+    fprintf(stderr, "Usage: %s [-c carts] [-s seed] [-n noise_ppm] [-w noise_width] [-f flake_ppm]\n"
+                    "          [-v violation_percent] [-o open_bus_percent]\n"
+                    "  -c  synthetic carts (default 2000)\n"
+                    "  -s  random seed (default 1)\n"
+                    "  -n  failure rate of passing cells near the frontier, per million (default 200)\n"
+                    "  -w  PWD steps above the frontier that are noisy (default 2)\n"
+                    "  -f  pass rate of the cell just below the frontier, per million (default 50)\n"
+                    "  -v  percent of carts with a frontier bump (default 10)\n"
+                    "  -o  percent of empty slots (default 5)\n", Program);
+}
+
+int main(int argc, char ** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= argc) {
+            Usage(argv[0]);
+            return 2;
+        }
+        unsigned long Value = strtoul(argv[++i], NULL, 0);
+        switch (argv[i - 1][1]) {
+            case 'c': NumCarts = (uint32_t)Value; break;
+            case 's': Seed = (uint32_t)Value; break;
+            case 'n': NoisePpm = (uint32_t)Value; break;
+            case 'w': NoiseWidth = (int)Value; break;
+            case 'f': FlakePpm = (uint32_t)Value; break;
+            case 'v': ViolationPercent = (int)Value; break;
+            case 'o': OpenBusPercent = (int)Value; break;
+            default:
+                Usage(argv[0]);
+                return 2;
+        }
+    }
+    if (Seed == 0) {
+        Seed = 1;  // xorshift32 is stuck at 0
+    }
+
+    sim_stats_t Stats[NUM_PI_SWEEP_STRATEGIES];
+    memset(Stats, 0, sizeof(Stats));
+    uint32_t Swept = 0;
+    uint32_t PresenceErrors = 0;
+    uint32_t Rng = Seed;
+
+    for (uint32_t n = 0; n < NumCarts; n++) {
+        sim_cart_t Cart;
+        MakeCart(&Cart, &Rng);
+        uint32_t CartSeed = Random(&Rng) | 1;
+
+        sim_bus_t Sim = { &Cart, CartSeed, 0, 0 };
+        pi_bus_t Bus = { SimProbe, SimReadWords, &Sim };
+        if (PiSweepDetectPresence(&Bus, SIM_DOM1_START) != Cart.Present) {
+            PresenceErrors++;
+        }
+        uint32_t FirstWord;
+        SimReadWords(&Sim, 0, &FirstWord, 1);
+        if (PiSweepWordIsOpenBus(SIM_DOM1_START, FirstWord) == Cart.Present) {
+            PresenceErrors++;
+        }
+        if (!Cart.Present) {
+            continue;
+        }
+
+        // Every strategy sees the same cart and the same noise seed
+        uint8_t Exhaustive[256];
+        RunCart(&Cart, CartSeed, PI_SWEEP_EXHAUSTIVE, &Stats[PI_SWEEP_EXHAUSTIVE], Exhaustive);
+        for (int Strategy = 0; Strategy < NUM_PI_SWEEP_STRATEGIES; Strategy++) {
+            if (Strategy == PI_SWEEP_EXHAUSTIVE) {
+                continue;
+            }
+            uint8_t Found[256];
+            RunCart(&Cart, CartSeed, (pi_sweep_strategy_t)Strategy, &Stats[Strategy], Found);
+            if (memcmp(Found, Exhaustive, sizeof(Found)) != 0) {
+                Stats[Strategy].DiffCarts++;
+            }
+        }
+        Swept++;
+    }
+
+    printf("%lu slot(s), %lu cart(s) swept, seed %lu\n",
+           (unsigned long)NumCarts, (unsigned long)Swept, (unsigned long)Seed);
+    printf("noise %lu ppm over %d PWD step(s), flake %lu ppm, bumps %d%%, empty %d%%\n",
+           (unsigned long)NoisePpm, NoiseWidth, (unsigned long)FlakePpm, ViolationPercent, OpenBusPercent);
+    printf("presence: %lu error(s)\n\n", (unsigned long)PresenceErrors);
+    if (Swept == 0) {
+        return 0;
+    }
+
+    printf("%-10s %10s %8s %10s %8s %8s %8s %8s %8s %8s\n",
+           "strategy", "probes", "max", "bus ms", "exact%", "carts%", "unsafe", "slow", "badpick", "loss%");
+    for (int Strategy = 0; Strategy < NUM_PI_SWEEP_STRATEGIES; Strategy++) {
+        const sim_stats_t * s = &Stats[Strategy];
+        uint64_t LATs = (uint64_t)Swept * 256;
+        printf("%-10s %10.1f %8lu %10.2f %8.2f %8.2f %8llu %8llu %8lu %8.3f\n",
+               PiSweepStrategyName((pi_sweep_strategy_t)Strategy),
+               (double)s->Probes / Swept, (unsigned long)s->MaxProbes,
+               (double)s->BusCycles / Swept * 1000.0 / PI_MODEL_RCP_HZ,
+               100.0 * s->ExactLATs / LATs, 100.0 * s->ExactCarts / Swept,
+               (unsigned long long)s->UnsafeLATs, (unsigned long long)s->SlowLATs,
+               (unsigned long)s->UnsafePicks, 100.0 * s->PickLoss / Swept);
+    }
+    printf("\nprobes and bus ms are per cart; unsafe/slow count LATs below/above the true minimum;\n"
+           "badpick counts carts whose fastest found timing fails; loss%% is the mean throughput\n"
+           "given up against the true fastest timing\n");
+
+    // Without noise every probe is repeatable, so any strategy must find the exhaustive table
+    if (NoisePpm == 0 && FlakePpm == 0) {
+        int Failed = 0;
+        for (int Strategy = 0; Strategy < NUM_PI_SWEEP_STRATEGIES; Strategy++) {
+            if (Stats[Strategy].DiffCarts > 0) {
+                printf("FAIL: %s differs from exhaustive on %lu noise-free cart(s)\n",
+                       PiSweepStrategyName((pi_sweep_strategy_t)Strategy), (unsigned long)Stats[Strategy].DiffCarts);
+                Failed = 1;
+            }
+        }
+        return Failed;
+    }
+    return 0;
+}